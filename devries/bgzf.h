@@ -0,0 +1,973 @@
+/*! \file
+ *
+ * \brief Read gzip and BGZF compressed files.
+ *
+ * BGZF (the format used by samtools and tabix) is a series of independent gzip
+ * blocks of at most 64 KiB, so the blocks can be decompressed in parallel and
+ * any position can be reached by decompressing a single block. Plain gzip files
+ * can only be decompressed sequentially. Uncompressed files are also accepted
+ * so the readers don't have to check the format themselves.
+ *
+ * 'bgzf_file' maps the file in memory, for random access. 'bgzf_stream' reads it
+ * through a fixed buffer (with the same memory whatever the size of the file),
+ * and also works with pipes.
+ *
+ * Requires zlib and POSIX threads (compile with -lz -pthread).
+ */ 
+
+#ifndef BGZF_H_
+#define BGZF_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <errno.h>
+#include <zlib.h>
+#include "devries.h"
+
+/* For C++ compilers: */
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * \brief Formats recognized by bgzf_format.
+ */
+typedef enum
+{
+    Plain = 0, /**< Not compressed. */
+    Gzip = 1, /**< gzip (one or more members). */
+    Bgzf = 2, /**< Blocked gzip. */
+}
+bgzf_type;
+
+/**
+ * \brief Number of blocks decompressed together when reading sequentially.
+ */
+#define BGZF_BATCH 64
+
+/**
+ * \brief Maximum size of an uncompressed BGZF block.
+ */
+#define BGZF_MAX_BLOCK 65536
+
+/**
+ * \brief Position of a BGZF block.
+ */
+typedef struct
+{
+    uint64_t coffset; /**< Offset of the block in the compressed file. */
+
+    uint64_t uoffset; /**< Offset of the block in the uncompressed data. */
+}
+bgzf_block;
+
+/**
+ * \brief A compressed (or not) file.
+ */
+typedef struct
+{
+    const unsigned char *cdata; /**< The mapped file (NULL if empty). */
+
+    size_t csize; /**< Size of the file. */
+
+    bgzf_type format; /**< Format of the file. */
+
+    unsigned int nthreads; /**< Number of threads used to decompress. */
+
+    bgzf_block *blocks; /**< All the blocks (BGZF with an index only). */
+
+    unsigned int nblocks; /**< Number of blocks in 'blocks'. */
+
+    uint64_t usize; /**< Uncompressed size (BGZF with an index only). */
+
+    uint64_t cpos; /**< Sequential reading: next compressed byte. */
+
+    char *buffer; /**< Sequential reading: uncompressed data not returned yet. */
+
+    size_t buffer_pos; /**< Sequential reading: next byte in 'buffer'. */
+
+    size_t buffer_end; /**< Sequential reading: number of bytes in 'buffer'. */
+
+    z_stream zs; /**< Sequential reading of gzip files. */
+
+    int zs_init; /**< 1 (TRUE) if 'zs' is initialized. */
+
+    int error; /**< 1 (TRUE) if a block or a member is corrupt or truncated. */
+}
+bgzf_file;
+
+/**
+ * \brief Detect the format of a file from its first bytes.
+ *
+ * \param data    Content of the file.
+ * \param size    Size of the file.
+ * \return        The format.
+ */
+bgzf_type bgzf_format(const unsigned char *data, size_t size)
+{
+    if (size < 18 || data[0] != 0x1f || data[1] != 0x8b || data[2] != 8)
+    {
+        return (size >= 2 && data[0] == 0x1f && data[1] == 0x8b) ? Gzip : Plain;
+    }
+    if ((data[3] & 4) && data[10] + (data[11] << 8) >= 6 &&
+        data[12] == 'B' && data[13] == 'C' && data[14] == 2 && data[15] == 0)
+    {
+        return Bgzf;
+    }
+    return Gzip;
+}
+
+/**
+ * \brief Number of threads to use (0 means one per processor).
+ */
+unsigned int bgzf_nthreads(unsigned int nthreads)
+{
+    if (nthreads == 0)
+    {
+        const long nprocs = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (nprocs > 0) ? (unsigned int)nprocs : 1;
+    }
+    return nthreads;
+}
+
+/**
+ * \brief Read the sizes of the BGZF block starting at 'coffset'.
+ *
+ * \param data       Content of the file.
+ * \param size       Size of the file.
+ * \param coffset    Offset of the block.
+ * \param bsize      Set to the size of the compressed block.
+ * \param isize      Set to the size of the uncompressed block.
+ * \return           1 (TRUE) if there is a valid block at 'coffset'.
+ */
+int bgzf_block_sizes(const unsigned char *data, size_t size, uint64_t coffset, size_t *bsize, unsigned int *isize)
+{
+    if (coffset + 18 > size || data[coffset] != 0x1f || data[coffset + 1] != 0x8b)
+    {
+        return FALSE;
+    }
+    const unsigned char *h = data + coffset;
+    *bsize = (size_t)(h[16] + (h[17] << 8)) + 1;
+    /* The header (12 bytes and XLEN of extra fields) and the footer must fit. */
+    if (*bsize < 26 || coffset + *bsize > size || 12 + (size_t)(h[10] + (h[11] << 8)) + 8 > *bsize)
+    {
+        return FALSE;
+    }
+    const unsigned char *t = h + *bsize - 4;
+    *isize = (unsigned int)t[0] | ((unsigned int)t[1] << 8) | ((unsigned int)t[2] << 16) | ((unsigned int)t[3] << 24);
+    return *isize <= BGZF_MAX_BLOCK;
+}
+
+/**
+ * \brief Shared state of the threads decompressing blocks.
+ */
+typedef struct
+{
+    const unsigned char *cdata; /**< The compressed file. */
+
+    size_t csize; /**< Size of the compressed file. */
+
+    const bgzf_block *blocks; /**< Blocks to decompress. */
+
+    unsigned int nblocks; /**< Number of blocks. */
+
+    char *dst; /**< Where to write the block starting at 'ubase'. */
+
+    uint64_t ubase; /**< Uncompressed offset of 'dst'. */
+
+    unsigned int next; /**< Next block to decompress. */
+
+    int error; /**< 1 (TRUE) if a block could not be decompressed. */
+
+    pthread_mutex_t lock; /**< Protects 'next' and 'error'. */
+}
+bgzf_job;
+
+/**
+ * \brief Main function of the threads: decompress blocks until there is none left.
+ *
+ * \param arg    The job.
+ * \return       NULL.
+ */
+void *bgzf_worker(void *arg)
+{
+    bgzf_job *job = (bgzf_job*)arg;
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    int ok = (inflateInit2(&zs, -15) == Z_OK); /* Raw deflate. */
+
+    for (;;)
+    {
+        pthread_mutex_lock(&job->lock);
+        const unsigned int i = job->next++;
+        if (!ok)
+        {
+            job->error = TRUE;
+        }
+        pthread_mutex_unlock(&job->lock);
+        if (i >= job->nblocks || !ok)
+        {
+            break;
+        }
+        size_t bsize;
+        unsigned int isize;
+        const uint64_t coffset = job->blocks[i].coffset;
+        if (!bgzf_block_sizes(job->cdata, job->csize, coffset, &bsize, &isize))
+        {
+            ok = FALSE;
+            continue;
+        }
+        const unsigned char *h = job->cdata + coffset;
+        const size_t header = 12 + (size_t)(h[10] + (h[11] << 8));
+        inflateReset(&zs);
+        zs.next_in = (Bytef*)(h + header);
+        zs.avail_in = (uInt)(bsize - header - 8);
+        zs.next_out = (Bytef*)(job->dst + (job->blocks[i].uoffset - job->ubase));
+        zs.avail_out = isize;
+        if (isize > 0 && (inflate(&zs, Z_FINISH) != Z_STREAM_END || zs.avail_out != 0))
+        {
+            ok = FALSE;
+        }
+    }
+    inflateEnd(&zs);
+    return NULL;
+}
+
+/**
+ * \brief Decompress BGZF blocks with several threads.
+ *
+ * Block i is written at dst + (blocks[i].uoffset - ubase).
+ *
+ * \param cdata      The compressed file.
+ * \param csize      Size of the compressed file.
+ * \param blocks     The blocks.
+ * \param nblocks    Number of blocks.
+ * \param dst        Destination.
+ * \param ubase      Uncompressed offset of 'dst'.
+ * \param nthreads   Number of threads.
+ * \return           1 (TRUE) if all the blocks were decompressed.
+ */
+int bgzf_inflate_blocks(const unsigned char *cdata, size_t csize, const bgzf_block *blocks, unsigned int nblocks,
+                        char *dst, uint64_t ubase, unsigned int nthreads)
+{
+    bgzf_job job;
+    job.cdata = cdata;
+    job.csize = csize;
+    job.blocks = blocks;
+    job.nblocks = nblocks;
+    job.dst = dst;
+    job.ubase = ubase;
+    job.next = 0;
+    job.error = FALSE;
+    pthread_mutex_init(&job.lock, NULL);
+
+    if (nthreads > nblocks)
+    {
+        nthreads = nblocks;
+    }
+    pthread_t *threads = (pthread_t*)malloc((nthreads > 0 ? nthreads : 1) * sizeof(pthread_t));
+    /* Threads that could not be created leave their share to the others. */
+    unsigned int created = 1;
+    for (; created < nthreads; ++created)
+    {
+        if (pthread_create(&threads[created], NULL, bgzf_worker, (void*)&job) != 0)
+        {
+            break;
+        }
+    }
+    bgzf_worker((void*)&job);
+    unsigned int i = 1;
+    for (; i < created; ++i)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+    pthread_mutex_destroy(&job.lock);
+    return !job.error;
+}
+
+/**
+ * \brief List the blocks of a BGZF file by jumping from header to header.
+ *
+ * \param cdata      The compressed file.
+ * \param csize      Size of the compressed file.
+ * \param coffset    Offset of the first block to list.
+ * \param uoffset    Uncompressed offset of the first block.
+ * \param max        Maximum number of blocks to list.
+ * \param blocks     Where to write the blocks (at least max + 1, the last one marks the end).
+ * \return           Number of blocks listed.
+ */
+unsigned int bgzf_list_blocks(const unsigned char *cdata, size_t csize, uint64_t coffset, uint64_t uoffset,
+                              unsigned int max, bgzf_block *blocks)
+{
+    unsigned int n = 0;
+    size_t bsize;
+    unsigned int isize;
+    while (n < max && bgzf_block_sizes(cdata, csize, coffset, &bsize, &isize))
+    {
+        blocks[n].coffset = coffset;
+        blocks[n].uoffset = uoffset;
+        ++n;
+        coffset += bsize;
+        uoffset += isize;
+    }
+    blocks[n].coffset = coffset;
+    blocks[n].uoffset = uoffset;
+    return n;
+}
+
+/**
+ * \brief Build the index of all the blocks of a BGZF file.
+ *
+ * \param bf    The file.
+ * \return      1 (TRUE) if the blocks cover the file, 0 (FALSE) and 'error' is
+ *              set if a block is invalid.
+ */
+int bgzf_index_build(bgzf_file *bf)
+{
+    unsigned int capacity = 1024;
+    bf->blocks = (bgzf_block*)malloc((capacity + 1) * sizeof(bgzf_block));
+    bf->nblocks = 0;
+    for (;;)
+    {
+        const uint64_t coffset = (bf->nblocks == 0) ? 0 : bf->blocks[bf->nblocks].coffset;
+        const uint64_t uoffset = (bf->nblocks == 0) ? 0 : bf->blocks[bf->nblocks].uoffset;
+        const unsigned int n = bgzf_list_blocks(bf->cdata, bf->csize, coffset, uoffset,
+                                                capacity - bf->nblocks, bf->blocks + bf->nblocks);
+        bf->nblocks += n;
+        if (bf->nblocks < capacity)
+        {
+            break;
+        }
+        capacity *= 2;
+        bf->blocks = (bgzf_block*)realloc((void*)bf->blocks, (capacity + 1) * sizeof(bgzf_block));
+    }
+    bf->usize = bf->blocks[bf->nblocks].uoffset;
+    if (bf->blocks[bf->nblocks].coffset != bf->csize)
+    {
+        bf->error = TRUE;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * \brief Write a 64 bits integer in little-endian order.
+ */
+void bgzf_write_u64(FILE *output, uint64_t x)
+{
+    unsigned char b[8];
+    int i = 0;
+    for (; i < 8; ++i)
+    {
+        b[i] = (unsigned char)(x >> (8 * i));
+    }
+    fwrite(b, 1, 8, output);
+}
+
+/**
+ * \brief Read a 64 bits integer in little-endian order.
+ */
+int bgzf_read_u64(FILE *input, uint64_t *x)
+{
+    unsigned char b[8];
+    if (fread(b, 1, 8, input) != 8)
+    {
+        return FALSE;
+    }
+    *x = 0;
+    int i = 7;
+    for (; i >= 0; --i)
+    {
+        *x = (*x << 8) | b[i];
+    }
+    return TRUE;
+}
+
+/**
+ * \brief Save the index of the blocks in the .gzi format of htslib.
+ *
+ * \param bf         The file.
+ * \param filename   Name of the index file.
+ * \return           1 (TRUE) if the index has been written.
+ */
+int bgzf_index_save(const bgzf_file *bf, const char *filename)
+{
+    FILE *output = fopen(filename, "wb");
+    if (output == NULL)
+    {
+        return FALSE;
+    }
+    /* The first block (at 0, 0) is implicit. */
+    bgzf_write_u64(output, bf->nblocks > 0 ? bf->nblocks - 1 : 0);
+    unsigned int i = 1;
+    for (; i < bf->nblocks; ++i)
+    {
+        bgzf_write_u64(output, bf->blocks[i].coffset);
+        bgzf_write_u64(output, bf->blocks[i].uoffset);
+    }
+    return fclose(output) == 0;
+}
+
+/**
+ * \brief Load the index of the blocks from a .gzi file.
+ *
+ * \param bf         The file.
+ * \param filename   Name of the index file.
+ * \return           1 (TRUE) if the index has been read.
+ */
+int bgzf_index_load(bgzf_file *bf, const char *filename)
+{
+    FILE *input = fopen(filename, "rb");
+    uint64_t n;
+    if (input == NULL)
+    {
+        return FALSE;
+    }
+    if (!bgzf_read_u64(input, &n) || n >= UINT_MAX - 1)
+    {
+        fclose(input);
+        return FALSE;
+    }
+    bf->nblocks = (unsigned int)n + 1;
+    bf->blocks = (bgzf_block*)malloc((bf->nblocks + 1) * sizeof(bgzf_block));
+    bf->blocks[0].coffset = 0;
+    bf->blocks[0].uoffset = 0;
+    unsigned int i = 1;
+    for (; i < bf->nblocks; ++i)
+    {
+        if (!bgzf_read_u64(input, &bf->blocks[i].coffset) || !bgzf_read_u64(input, &bf->blocks[i].uoffset))
+        {
+            break;
+        }
+    }
+    fclose(input);
+
+    /* The end of the last block is not in the file. */
+    size_t bsize;
+    unsigned int isize;
+    const bgzf_block *last = &bf->blocks[bf->nblocks - 1];
+    if (i < bf->nblocks || !bgzf_block_sizes(bf->cdata, bf->csize, last->coffset, &bsize, &isize))
+    {
+        free(bf->blocks);
+        bf->blocks = NULL;
+        bf->nblocks = 0;
+        return FALSE;
+    }
+    bf->blocks[bf->nblocks].coffset = last->coffset + bsize;
+    bf->blocks[bf->nblocks].uoffset = last->uoffset + isize;
+    bf->usize = bf->blocks[bf->nblocks].uoffset;
+    return TRUE;
+}
+
+/**
+ * \brief Open a file for reading.
+ *
+ * The file is mapped in memory, so it has to be a regular file (see
+ * 'bgzf_stream' for pipes).
+ *
+ * \param bf         A pointer to an unitialized 'bgzf_file' object.
+ * \param filename   Name of the file.
+ * \param nthreads   Number of threads used to decompress BGZF blocks (0 for one per processor).
+ * \return           1 (TRUE) if the file has been opened.
+ */
+int bgzf_open(bgzf_file *bf, const char *filename, unsigned int nthreads)
+{
+    struct stat st;
+    const int fd = open(filename, O_RDONLY);
+
+    memset(bf, 0, sizeof(bgzf_file));
+    if (fd < 0)
+    {
+        return FALSE;
+    }
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        close(fd);
+        return FALSE;
+    }
+    bf->csize = (size_t)st.st_size;
+    if (bf->csize > 0)
+    {
+        void *data = mmap(NULL, bf->csize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            return FALSE;
+        }
+        bf->cdata = (const unsigned char*)data;
+    }
+    close(fd);
+    bf->format = bgzf_format(bf->cdata, bf->csize);
+    bf->nthreads = bgzf_nthreads(nthreads);
+    return TRUE;
+}
+
+/**
+ * \brief Load (or build and save) the index of the blocks of a BGZF file.
+ *
+ * The index is read from filename.gzi if it exists and is not older than the
+ * file, otherwise it is built and saved (failing to save it is not an error).
+ *
+ * \param bf         The file.
+ * \param filename   Name of the file.
+ * \return           1 (TRUE) if the file is in BGZF format and is indexed,
+ *                   0 (FALSE) if it is not BGZF or has an invalid block.
+ */
+int bgzf_index(bgzf_file *bf, const char *filename)
+{
+    if (bf->format != Bgzf)
+    {
+        return FALSE;
+    }
+    if (bf->blocks != NULL)
+    {
+        return TRUE;
+    }
+    char *gzi_filename = (char*)malloc(strlen(filename) + 5);
+    sprintf(gzi_filename, "%s.gzi", filename);
+
+    struct stat st, gzi_st;
+    if (!(stat(filename, &st) == 0 && stat(gzi_filename, &gzi_st) == 0 &&
+          gzi_st.st_mtime >= st.st_mtime && bgzf_index_load(bf, gzi_filename)))
+    {
+        if (!bgzf_index_build(bf))
+        {
+            free(gzi_filename);
+            return FALSE;
+        }
+        bgzf_index_save(bf, gzi_filename);
+    }
+    free(gzi_filename);
+    return TRUE;
+}
+
+/**
+ * \brief Close a file.
+ *
+ * \param bf    The file.
+ */
+void bgzf_close(bgzf_file *bf)
+{
+    if (bf->cdata != NULL)
+    {
+        munmap((void*)bf->cdata, bf->csize);
+    }
+    if (bf->zs_init)
+    {
+        inflateEnd(&bf->zs);
+    }
+    free(bf->blocks);
+    free(bf->buffer);
+    memset(bf, 0, sizeof(bgzf_file));
+}
+
+/**
+ * \brief Decompress the next batch of data for sequential reading.
+ *
+ * \param bf    The file.
+ * \return      1 (TRUE) if some data was decompressed, 0 (FALSE) at the end of
+ *              the file or on error (see 'error').
+ */
+int bgzf_refill(bgzf_file *bf)
+{
+    if (bf->buffer == NULL)
+    {
+        bf->buffer = (char*)malloc(BGZF_BATCH * BGZF_MAX_BLOCK);
+    }
+    bf->buffer_pos = 0;
+    bf->buffer_end = 0;
+    if (bf->format == Bgzf)
+    {
+        bgzf_block blocks[BGZF_BATCH + 1];
+        const unsigned int n = bgzf_list_blocks(bf->cdata, bf->csize, bf->cpos, 0, BGZF_BATCH, blocks);
+        if (n == 0)
+        {
+            /* Anything but the end of the file is a bad block. */
+            bf->error = (bf->cpos < bf->csize);
+            return FALSE;
+        }
+        if (!bgzf_inflate_blocks(bf->cdata, bf->csize, blocks, n, bf->buffer, 0, bf->nthreads))
+        {
+            bf->error = TRUE;
+            return FALSE;
+        }
+        bf->cpos = blocks[n].coffset;
+        bf->buffer_end = (size_t)blocks[n].uoffset;
+        return TRUE;
+    }
+    if (!bf->zs_init)
+    {
+        memset(&bf->zs, 0, sizeof(z_stream));
+        if (inflateInit2(&bf->zs, 16 + MAX_WBITS) != Z_OK)
+        {
+            return FALSE;
+        }
+        bf->zs_init = TRUE;
+    }
+    /* Done at the end of the file between two members (zlib may still hold output). */
+    if (bf->error || (bf->cpos >= bf->csize && bf->zs.total_in == 0))
+    {
+        return FALSE;
+    }
+    bf->zs.next_out = (Bytef*)bf->buffer;
+    bf->zs.avail_out = BGZF_BATCH * BGZF_MAX_BLOCK;
+    while (bf->zs.avail_out > 0)
+    {
+        const size_t left = bf->csize - bf->cpos;
+        bf->zs.next_in = (Bytef*)(bf->cdata + bf->cpos);
+        bf->zs.avail_in = (uInt)(left > (1U << 30) ? (1U << 30) : left);
+        const uInt avail_in = bf->zs.avail_in;
+        const int ret = inflate(&bf->zs, Z_NO_FLUSH);
+        bf->cpos += avail_in - bf->zs.avail_in;
+        if (ret == Z_STREAM_END)
+        {
+            /* Concatenated members, unless what follows is not gzip. */
+            if (bgzf_format(bf->cdata + bf->cpos, bf->csize - bf->cpos) == Plain)
+            {
+                bf->cpos = bf->csize;
+            }
+            inflateReset(&bf->zs);
+            if (bf->cpos >= bf->csize)
+            {
+                break;
+            }
+        }
+        else if (ret != Z_OK)
+        {
+            /* Corrupt data, or the file ends within a member (Z_BUF_ERROR). */
+            bf->error = TRUE;
+            break;
+        }
+    }
+    bf->buffer_end = BGZF_BATCH * BGZF_MAX_BLOCK - bf->zs.avail_out;
+    return TRUE;
+}
+
+/**
+ * \brief Read the next bytes of the uncompressed data.
+ *
+ * BGZF blocks are decompressed in parallel by batches of BGZF_BATCH blocks.
+ *
+ * \param bf      The file.
+ * \param dst     Where to write the data.
+ * \param size    Maximum number of bytes to read.
+ * \return        Number of bytes read (0 at the end of the file or on error,
+ *                see 'error').
+ */
+size_t bgzf_read(bgzf_file *bf, char *dst, size_t size)
+{
+    if (bf->format == Plain)
+    {
+        const size_t n = (bf->cpos + size > bf->csize) ? (size_t)(bf->csize - bf->cpos) : size;
+        memcpy(dst, bf->cdata + bf->cpos, n);
+        bf->cpos += n;
+        return n;
+    }
+    while (bf->buffer_pos == bf->buffer_end)
+    {
+        if (!bgzf_refill(bf))
+        {
+            return 0;
+        }
+    }
+    const size_t n = (size > bf->buffer_end - bf->buffer_pos) ? bf->buffer_end - bf->buffer_pos : size;
+    memcpy(dst, bf->buffer + bf->buffer_pos, n);
+    bf->buffer_pos += n;
+    return n;
+}
+
+/**
+ * \brief Read a range of the uncompressed data of an indexed BGZF file.
+ *
+ * Only the blocks overlapping the range are decompressed (in parallel).
+ *
+ * \param bf       The file (see bgzf_index).
+ * \param begin    First byte of the range.
+ * \param end      One past the last byte (clipped to the size of the data).
+ * \param dst      Where to write the end - begin bytes.
+ * \return         1 (TRUE) if the range was read.
+ */
+int bgzf_read_range(const bgzf_file *bf, uint64_t begin, uint64_t end, char *dst)
+{
+    assert(bf->blocks != NULL);
+    if (end > bf->usize)
+    {
+        end = bf->usize;
+    }
+    if (begin >= end)
+    {
+        return begin == end;
+    }
+    /* Last block starting at or before 'begin'. */
+    unsigned int lo = 0, hi = bf->nblocks;
+    while (hi - lo > 1)
+    {
+        const unsigned int mid = lo + (hi - lo) / 2;
+        if (bf->blocks[mid].uoffset <= begin)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    unsigned int last = lo;
+    while (bf->blocks[last + 1].uoffset < end)
+    {
+        ++last;
+    }
+    const unsigned int n = last - lo + 1;
+    const uint64_t ubase = bf->blocks[lo].uoffset;
+    const uint64_t uend = bf->blocks[last + 1].uoffset;
+
+    if (ubase == begin && uend == end)
+    {
+        return bgzf_inflate_blocks(bf->cdata, bf->csize, bf->blocks + lo, n, dst, ubase, bf->nthreads);
+    }
+    char *tmp = (char*)malloc((size_t)(uend - ubase));
+    const int ok = bgzf_inflate_blocks(bf->cdata, bf->csize, bf->blocks + lo, n, tmp, ubase, bf->nthreads);
+    memcpy(dst, tmp + (begin - ubase), (size_t)(end - begin));
+    free(tmp);
+    return ok;
+}
+
+/**
+ * \brief Decompress a whole file in memory.
+ *
+ * \param bf      The file.
+ * \param size    Set to the size of the uncompressed data.
+ * \return        The uncompressed data (to free with free), NULL if the file
+ *                is corrupt or truncated.
+ */
+char *bgzf_read_all(bgzf_file *bf, size_t *size)
+{
+    *size = 0;
+    if (bf->format == Bgzf)
+    {
+        if (bf->blocks == NULL && !bgzf_index_build(bf))
+        {
+            return NULL;
+        }
+        char *data = (char*)malloc((size_t)bf->usize + 1);
+        if (!bgzf_inflate_blocks(bf->cdata, bf->csize, bf->blocks, bf->nblocks, data, 0, bf->nthreads))
+        {
+            free(data);
+            return NULL;
+        }
+        *size = (size_t)bf->usize;
+        return data;
+    }
+    size_t capacity = (bf->csize < 1024) ? 4096 : 4 * bf->csize;
+    char *data = (char*)malloc(capacity);
+    size_t n;
+    while ((n = bgzf_read(bf, data + *size, capacity - *size)) > 0)
+    {
+        *size += n;
+        if (*size == capacity)
+        {
+            capacity *= 2;
+            data = (char*)realloc((void*)data, capacity);
+        }
+    }
+    if (bf->error)
+    {
+        free(data);
+        *size = 0;
+        return NULL;
+    }
+    return data;
+}
+
+/**
+ * \brief A compressed (or not) file read sequentially through a fixed buffer.
+ */
+typedef struct
+{
+    int fd; /**< The file descriptor. */
+
+    bgzf_type format; /**< Format of the file (BGZF is read as gzip). */
+
+    unsigned char *in; /**< Input buffer (BGZF_MAX_BLOCK bytes). */
+
+    size_t in_pos; /**< Next byte in 'in'. */
+
+    size_t in_end; /**< Number of bytes in 'in'. */
+
+    int eof; /**< 1 (TRUE) once the end of the file has been read. */
+
+    int error; /**< 1 (TRUE) if reading or decompressing failed. */
+
+    z_stream zs; /**< Decompression state (gzip and BGZF). */
+
+    int zs_init; /**< 1 (TRUE) if 'zs' is initialized. */
+}
+bgzf_stream;
+
+/**
+ * \brief Read more bytes at the end of the input buffer (moving the unread ones first).
+ *
+ * \return      Number of bytes read (0 at the end of the file or on error).
+ */
+size_t bgzf_stream_input(bgzf_stream *bs)
+{
+    if (bs->in_pos > 0)
+    {
+        memmove(bs->in, bs->in + bs->in_pos, bs->in_end - bs->in_pos);
+        bs->in_end -= bs->in_pos;
+        bs->in_pos = 0;
+    }
+    if (bs->eof || bs->in_end == BGZF_MAX_BLOCK)
+    {
+        return 0;
+    }
+    ssize_t n;
+    do
+    {
+        n = read(bs->fd, bs->in + bs->in_end, BGZF_MAX_BLOCK - bs->in_end);
+    }
+    while (n < 0 && errno == EINTR);
+    if (n <= 0)
+    {
+        bs->eof = TRUE;
+        bs->error = (n < 0);
+        return 0;
+    }
+    bs->in_end += (size_t)n;
+    return (size_t)n;
+}
+
+/**
+ * \brief Open a file (or a pipe) for sequential reading.
+ *
+ * \param bs         A pointer to an unitialized 'bgzf_stream' object.
+ * \param filename   Name of the file.
+ * \return           1 (TRUE) if the file has been opened.
+ */
+int bgzf_stream_open(bgzf_stream *bs, const char *filename)
+{
+    memset(bs, 0, sizeof(bgzf_stream));
+    bs->fd = open(filename, O_RDONLY);
+    if (bs->fd < 0)
+    {
+        return FALSE;
+    }
+    bs->in = (unsigned char*)malloc(BGZF_MAX_BLOCK);
+    /* Enough bytes to recognize the format (pipes may return less). */
+    while (bs->in_end < 18 && bgzf_stream_input(bs) > 0);
+    if (bs->error)
+    {
+        close(bs->fd);
+        free(bs->in);
+        return FALSE;
+    }
+    bs->format = bgzf_format(bs->in, bs->in_end);
+    return TRUE;
+}
+
+/**
+ * \brief Close a stream.
+ *
+ * \param bs    The stream.
+ */
+void bgzf_stream_close(bgzf_stream *bs)
+{
+    if (bs->zs_init)
+    {
+        inflateEnd(&bs->zs);
+    }
+    close(bs->fd);
+    free(bs->in);
+    memset(bs, 0, sizeof(bgzf_stream));
+    bs->fd = -1;
+}
+
+/**
+ * \brief Read the next bytes of the uncompressed data.
+ *
+ * Gzip members (and so BGZF blocks) are decompressed one after the other.
+ *
+ * \param bs      The stream.
+ * \param dst     Where to write the data.
+ * \param size    Maximum number of bytes to read.
+ * \return        Number of bytes read, 0 only at the end of the file or on
+ *                error (see 'error').
+ */
+size_t bgzf_stream_read(bgzf_stream *bs, char *dst, size_t size)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+    if (bs->format == Plain)
+    {
+        if (bs->in_pos == bs->in_end && bgzf_stream_input(bs) == 0)
+        {
+            return 0;
+        }
+        const size_t n = (size > bs->in_end - bs->in_pos) ? bs->in_end - bs->in_pos : size;
+        memcpy(dst, bs->in + bs->in_pos, n);
+        bs->in_pos += n;
+        return n;
+    }
+
+    if (!bs->zs_init)
+    {
+        if (inflateInit2(&bs->zs, 16 + MAX_WBITS) != Z_OK)
+        {
+            bs->error = TRUE;
+            return 0;
+        }
+        bs->zs_init = TRUE;
+    }
+    bs->zs.next_out = (Bytef*)dst;
+    bs->zs.avail_out = (uInt)(size > (1U << 30) ? (1U << 30) : size);
+    const uInt avail_out = bs->zs.avail_out;
+    while (bs->zs.avail_out == avail_out && !bs->error)
+    {
+        if (bs->in_pos == bs->in_end && bgzf_stream_input(bs) == 0)
+        {
+            /* End of the file: fine between members, an error within one. */
+            bs->error = bs->error || (bs->zs.total_in > 0);
+            break;
+        }
+        bs->zs.next_in = (Bytef*)(bs->in + bs->in_pos);
+        bs->zs.avail_in = (uInt)(bs->in_end - bs->in_pos);
+        const int ret = inflate(&bs->zs, Z_NO_FLUSH);
+        bs->in_pos = bs->in_end - bs->zs.avail_in;
+        if (ret == Z_STREAM_END)
+        {
+            /* Concatenated members, unless what follows is not gzip. */
+            inflateReset(&bs->zs);
+            while (bs->in_end - bs->in_pos < 2 && bgzf_stream_input(bs) > 0);
+            if (bgzf_format(bs->in + bs->in_pos, bs->in_end - bs->in_pos) == Plain)
+            {
+                bs->in_pos = bs->in_end;
+                bs->eof = TRUE;
+                break;
+            }
+        }
+        else if (ret != Z_OK)
+        {
+            bs->error = TRUE;
+        }
+    }
+    return avail_out - bs->zs.avail_out;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
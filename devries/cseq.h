@@ -0,0 +1,720 @@
+/*! \file
+ *
+ * \brief Compressed DNA sequences (2 bits per nucleotide).
+ *
+ * 'A', 'C', 'G' and 'T' are stored with 2 bits (0, 1, 2 and 3, so the
+ * complement of a nucleotide is 3 minus its code), 32 nucleotides per 64-bit
+ * word. The other residues ('N', IUPAC ambiguity codes, ...) are rare and come
+ * in runs, so they are kept in a sorted list of runs beside the bitfield
+ * (where they are stored as 'A'). Lowercase nucleotides are stored uppercase.
+ */ 
+
+#ifndef CSEQ_H_
+#define CSEQ_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include "devries.h"
+
+/* For C++ compilers: */
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * \brief Number of nucleotides in a word of a compressed sequence.
+ */
+#define CSEQ_WORD 32
+
+/**
+ * \brief Code of a residue: 0 to 3 for 'A', 'C', 'G', 'T' (any case), 4 for the others.
+ */
+static const unsigned char cseq_code[256] =
+{
+    4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4, 4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,
+    4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4, 4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,
+    4,0,4,1,4,4,4,2,4,4,4,4,4,4,4,4, 4,4,4,4,3,4,4,4,4,4,4,4,4,4,4,4,
+    4,0,4,1,4,4,4,2,4,4,4,4,4,4,4,4, 4,4,4,4,3,4,4,4,4,4,4,4,4,4,4,4,
+    4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4, 4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,
+    4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4, 4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,
+    4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4, 4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,
+    4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4, 4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4
+};
+
+/**
+ * \brief A run of identical residues that are not 'A', 'C', 'G' or 'T'.
+ */
+typedef struct
+{
+    unsigned int pos; /**< Position of the first residue of the run. */
+
+    unsigned int length; /**< Number of residues in the run. */
+
+    char c; /**< The residue. */
+}
+cseq_run;
+
+/**
+ * \brief A compressed sequence represented by a bitfield.
+ */
+typedef struct
+{
+    uint64_t *seq; /**< The sequence, CSEQ_WORD nucleotides per word. */
+
+    unsigned int length; /**< Length of the sequence. */
+
+    unsigned int capacity; /**< Capacity of the object (in nucleotides). */
+
+    cseq_run *amb; /**< Runs of other residues, sorted by position. */
+
+    unsigned int namb; /**< Number of runs. */
+
+    unsigned int amb_capacity; /**< Capacity of the array of runs. */
+}
+cseq;
+
+/**
+ * \brief Number of bits set in a word.
+ */
+unsigned int cseq_popcount(uint64_t w)
+{
+#if defined(__GNUC__)
+    return (unsigned int)__builtin_popcountll(w);
+#else
+    w = w - ((w >> 1) & 0x5555555555555555ULL);
+    w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+    w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (unsigned int)((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/**
+ * \brief Initialize an empty compressed sequence.
+ *
+ * \param cs         A pointer to an unitialized 'cseq' object.
+ * \param capacity   Initial capacity (in nucleotides).
+ */
+void cseq_init(cseq *cs, unsigned int capacity)
+{
+    const unsigned int nwords = (capacity + CSEQ_WORD - 1) / CSEQ_WORD;
+    cs->seq = (uint64_t*)calloc(nwords > 0 ? nwords : 1, sizeof(uint64_t));
+    cs->length = 0;
+    cs->capacity = nwords * CSEQ_WORD;
+    cs->amb = NULL;
+    cs->namb = 0;
+    cs->amb_capacity = 0;
+}
+
+/**
+ * \brief Free the memory of a compressed sequence.
+ *
+ * \param cs    The compressed sequence.
+ */
+void cseq_free(cseq *cs)
+{
+    free(cs->seq);
+    free(cs->amb);
+    cs->seq = NULL;
+    cs->amb = NULL;
+    cs->length = 0;
+    cs->capacity = 0;
+    cs->namb = 0;
+    cs->amb_capacity = 0;
+}
+
+/**
+ * \brief Make sure the sequence can hold 'capacity' nucleotides.
+ *
+ * \param cs         The compressed sequence.
+ * \param capacity   Minimum capacity (in nucleotides).
+ */
+void cseq_reserve(cseq *cs, unsigned int capacity)
+{
+    if (capacity <= cs->capacity)
+    {
+        return;
+    }
+    const unsigned int old_nwords = cs->capacity / CSEQ_WORD;
+    const unsigned int nwords = (capacity + CSEQ_WORD - 1) / CSEQ_WORD;
+    cs->seq = (uint64_t*)realloc((void*)cs->seq, nwords * sizeof(uint64_t));
+    memset(cs->seq + old_nwords, 0, (nwords - old_nwords) * sizeof(uint64_t));
+    cs->capacity = nwords * CSEQ_WORD;
+}
+
+/**
+ * \brief Index of the last run starting at or before 'pos' (-1 if none).
+ */
+int cseq_find_run(const cseq *cs, unsigned int pos)
+{
+    int lo = -1, hi = (int)cs->namb;
+    while (hi - lo > 1)
+    {
+        const int mid = lo + (hi - lo) / 2;
+        if (cs->amb[mid].pos <= pos)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * \brief Insert a run at index i of the array of runs.
+ */
+void cseq_insert_run(cseq *cs, unsigned int i, unsigned int pos, unsigned int length, char c)
+{
+    if (cs->namb == cs->amb_capacity)
+    {
+        cs->amb_capacity = (cs->amb_capacity == 0) ? 8 : 2 * cs->amb_capacity;
+        cs->amb = (cseq_run*)realloc((void*)cs->amb, cs->amb_capacity * sizeof(cseq_run));
+    }
+    memmove(cs->amb + i + 1, cs->amb + i, (cs->namb - i) * sizeof(cseq_run));
+    cs->amb[i].pos = pos;
+    cs->amb[i].length = length;
+    cs->amb[i].c = c;
+    ++cs->namb;
+}
+
+/**
+ * \brief Mark position 'pos' as the residue 'c' in the runs (merging with the neighbours).
+ */
+void cseq_add_amb(cseq *cs, unsigned int pos, char c)
+{
+    const int r = cseq_find_run(cs, pos);
+    cseq_run *prev = (r >= 0) ? &cs->amb[r] : NULL;
+    cseq_run *next = (r + 1 < (int)cs->namb) ? &cs->amb[r + 1] : NULL;
+
+    if (prev != NULL && prev->pos + prev->length == pos && prev->c == c)
+    {
+        ++prev->length;
+        if (next != NULL && next->pos == pos + 1 && next->c == c)
+        {
+            prev->length += next->length;
+            memmove(next, next + 1, (cs->namb - r - 2) * sizeof(cseq_run));
+            --cs->namb;
+        }
+    }
+    else if (next != NULL && next->pos == pos + 1 && next->c == c)
+    {
+        --next->pos;
+        ++next->length;
+    }
+    else
+    {
+        cseq_insert_run(cs, (unsigned int)(r + 1), pos, 1, c);
+    }
+}
+
+/**
+ * \brief Remove position 'pos' from the runs (if it is in a run).
+ */
+void cseq_rmv_amb(cseq *cs, unsigned int pos)
+{
+    const int r = cseq_find_run(cs, pos);
+    if (r < 0 || pos >= cs->amb[r].pos + cs->amb[r].length)
+    {
+        return;
+    }
+    cseq_run *run = &cs->amb[r];
+    const unsigned int end = run->pos + run->length;
+    if (run->length == 1)
+    {
+        memmove(run, run + 1, (cs->namb - r - 1) * sizeof(cseq_run));
+        --cs->namb;
+    }
+    else if (pos == run->pos)
+    {
+        ++run->pos;
+        --run->length;
+    }
+    else if (pos == end - 1)
+    {
+        --run->length;
+    }
+    else
+    {
+        run->length = pos - run->pos;
+        cseq_insert_run(cs, (unsigned int)(r + 1), pos + 1, end - pos - 1, run->c);
+    }
+}
+
+/**
+ * \brief Add residues at the end of the sequence.
+ *
+ * The capacity is doubled when needed so appending is amortized \f$O(1)\f$ per
+ * residue. Whole words are packed at once when possible.
+ *
+ * \param cs       The compressed sequence.
+ * \param seq      The residues.
+ * \param length   Number of residues.
+ */
+void cseq_append(cseq *cs, const char *seq, unsigned int length)
+{
+    if (cs->length + length > cs->capacity)
+    {
+        const unsigned int capacity = 2 * cs->capacity;
+        cseq_reserve(cs, (cs->length + length > capacity) ? cs->length + length : capacity);
+    }
+    unsigned int i = 0;
+    unsigned int pos = cs->length;
+
+    /* Residues up to the next word boundary. */
+    for (; i < length && pos % CSEQ_WORD != 0; ++i, ++pos)
+    {
+        const unsigned char code = cseq_code[(unsigned char)seq[i]];
+        if (code == 4)
+        {
+            cseq_add_amb(cs, pos, seq[i]);
+        }
+        else
+        {
+            cs->seq[pos / CSEQ_WORD] |= (uint64_t)code << (2 * (pos % CSEQ_WORD));
+        }
+    }
+    /* Whole words. */
+    for (; i + CSEQ_WORD <= length; i += CSEQ_WORD, pos += CSEQ_WORD)
+    {
+        uint64_t w = 0;
+        unsigned char other = 0;
+        unsigned int k = 0;
+        for (; k < CSEQ_WORD; ++k)
+        {
+            const unsigned char code = cseq_code[(unsigned char)seq[i + k]];
+            other |= code;
+            w |= (uint64_t)(code & 3) << (2 * k);
+        }
+        if (other & 4)
+        {
+            w = 0;
+            for (k = 0; k < CSEQ_WORD; ++k)
+            {
+                const unsigned char code = cseq_code[(unsigned char)seq[i + k]];
+                if (code == 4)
+                {
+                    cseq_add_amb(cs, pos + k, seq[i + k]);
+                }
+                else
+                {
+                    w |= (uint64_t)code << (2 * k);
+                }
+            }
+        }
+        cs->seq[pos / CSEQ_WORD] = w;
+    }
+    /* The rest. */
+    for (; i < length; ++i, ++pos)
+    {
+        const unsigned char code = cseq_code[(unsigned char)seq[i]];
+        if (code == 4)
+        {
+            cseq_add_amb(cs, pos, seq[i]);
+        }
+        else
+        {
+            cs->seq[pos / CSEQ_WORD] |= (uint64_t)code << (2 * (pos % CSEQ_WORD));
+        }
+    }
+    cs->length = pos;
+}
+
+/**
+ * \brief Compress a sequence.
+ *
+ * \param cs       A pointer to an unitialized 'cseq' object.
+ * \param seq      The sequence.
+ * \param length   Length of the sequence.
+ */
+void cseq_pack(cseq *cs, const char *seq, unsigned int length)
+{
+    cseq_init(cs, length);
+    cseq_append(cs, seq, length);
+}
+
+/**
+ * \brief Return the residue at position i.
+ *
+ * \f$O(1)\f$ for a sequence of 'A', 'C', 'G' and 'T', \f$O(\log r)\f$ with r runs
+ * of other residues.
+ *
+ * \param cs    The compressed sequence.
+ * \param i     Position of the residue.
+ * \return      The residue.
+ */
+char cseq_get(const cseq *cs, unsigned int i)
+{
+    assert(i < cs->length);
+    if (cs->namb > 0)
+    {
+        const int r = cseq_find_run(cs, i);
+        if (r >= 0 && i < cs->amb[r].pos + cs->amb[r].length)
+        {
+            return cs->amb[r].c;
+        }
+    }
+    return "ACGT"[(cs->seq[i / CSEQ_WORD] >> (2 * (i % CSEQ_WORD))) & 3];
+}
+
+/**
+ * \brief Change the residue at position i.
+ *
+ * \param cs    The compressed sequence.
+ * \param i     Position of the residue.
+ * \param c     The new residue.
+ */
+void cseq_set(cseq *cs, unsigned int i, char c)
+{
+    assert(i < cs->length);
+    const unsigned char code = cseq_code[(unsigned char)c];
+    const unsigned int shift = 2 * (i % CSEQ_WORD);
+    if (cs->namb > 0)
+    {
+        cseq_rmv_amb(cs, i);
+    }
+    cs->seq[i / CSEQ_WORD] &= ~((uint64_t)3 << shift);
+    if (code == 4)
+    {
+        cseq_add_amb(cs, i, c);
+    }
+    else
+    {
+        cs->seq[i / CSEQ_WORD] |= (uint64_t)code << shift;
+    }
+}
+
+/**
+ * \brief Decompress a sequence into a buffer.
+ *
+ * \param cs     The compressed sequence.
+ * \param dst    Where to write the length + 1 residues (NUL-terminated).
+ */
+void cseq_unpack(const cseq *cs, char *dst)
+{
+    unsigned int i = 0;
+    for (; i + CSEQ_WORD <= cs->length; i += CSEQ_WORD)
+    {
+        uint64_t w = cs->seq[i / CSEQ_WORD];
+        unsigned int k = 0;
+        for (; k < CSEQ_WORD; ++k, w >>= 2)
+        {
+            dst[i + k] = "ACGT"[w & 3];
+        }
+    }
+    for (; i < cs->length; ++i)
+    {
+        dst[i] = "ACGT"[(cs->seq[i / CSEQ_WORD] >> (2 * (i % CSEQ_WORD))) & 3];
+    }
+    unsigned int r = 0;
+    for (; r < cs->namb; ++r)
+    {
+        memset(dst + cs->amb[r].pos, cs->amb[r].c, cs->amb[r].length);
+    }
+    dst[cs->length] = '\0';
+}
+
+/**
+ * \brief Return a decompressed copy of the sequence.
+ *
+ * \param cs    The compressed sequence.
+ * \return      The sequence (NUL-terminated, to free with free).
+ */
+char *cseq_to_string(const cseq *cs)
+{
+    char *seq = (char*)malloc(cs->length + 1);
+    cseq_unpack(cs, seq);
+    return seq;
+}
+
+/**
+ * \brief Count the 'A', 'C', 'G' and 'T' with one popcount per word and per nucleotide.
+ *
+ * \param cs        The compressed sequence.
+ * \param counts    Set to the number of 'A', 'C', 'G' and 'T'.
+ */
+void cseq_count_all(const cseq *cs, unsigned int counts[4])
+{
+    const unsigned int nwords = (cs->length + CSEQ_WORD - 1) / CSEQ_WORD;
+    unsigned int c = 0, g = 0, t = 0;
+    unsigned int i = 0;
+    for (; i < nwords; ++i)
+    {
+        /* Bits past the end of the sequence are always 0 ('A'). */
+        const uint64_t w = cs->seq[i];
+        const uint64_t lo = w & 0x5555555555555555ULL;
+        const uint64_t hi = (w >> 1) & 0x5555555555555555ULL;
+        c += cseq_popcount(lo & ~hi);
+        g += cseq_popcount(hi & ~lo);
+        t += cseq_popcount(lo & hi);
+    }
+    unsigned int other = 0;
+    for (i = 0; i < cs->namb; ++i)
+    {
+        other += cs->amb[i].length;
+    }
+    counts[0] = cs->length - c - g - t - other;
+    counts[1] = c;
+    counts[2] = g;
+    counts[3] = t;
+}
+
+/**
+ * \brief Count the occurences of a residue in a compressed sequence.
+ *
+ * \param cs    The compressed sequence.
+ * \param c     The residue.
+ * \return      The number of occurences.
+ */
+unsigned int cseq_count(const cseq *cs, char c)
+{
+    const unsigned char code = cseq_code[(unsigned char)c];
+    if (code == 4 || (c >= 'a' && c <= 'z'))
+    {
+        unsigned int count = 0;
+        unsigned int i = 0;
+        for (; i < cs->namb; ++i)
+        {
+            count += (cs->amb[i].c == c) ? cs->amb[i].length : 0;
+        }
+        return count;
+    }
+    unsigned int counts[4];
+    cseq_count_all(cs, counts);
+    return counts[code];
+}
+
+/**
+ * \brief Count the number of cytosine 'C' and guanine 'G' in a compressed sequence.
+ *
+ * \param cs    The compressed sequence.
+ * \return      The number of cytosine 'C' and guanine 'G'.
+ */
+unsigned int cseq_gc_count(const cseq *cs)
+{
+    unsigned int counts[4];
+    cseq_count_all(cs, counts);
+    return counts[1] + counts[2];
+}
+
+/**
+ * \brief IUPAC complement of a residue (any case, 'U' gives 'A', other residues are unchanged).
+ */
+static const unsigned char iupac_complement[256] =
+{
+      0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,  15,
+     16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,  30,  31,
+    ' ', '!', '"', '#', '$', '%', '&', '\'', '(', ')', '*', '+', ',', '-', '.', '/',
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', ':', ';', '<', '=', '>', '?',
+    '@', 'T', 'V', 'G', 'H', 'E', 'F', 'C', 'D', 'I', 'J', 'M', 'L', 'K', 'N', 'O',
+    'P', 'Q', 'Y', 'S', 'A', 'A', 'B', 'W', 'X', 'R', 'Z', '[', '\\', ']', '^', '_',
+    '`', 't', 'v', 'g', 'h', 'e', 'f', 'c', 'd', 'i', 'j', 'm', 'l', 'k', 'n', 'o',
+    'p', 'q', 'y', 's', 'a', 'a', 'b', 'w', 'x', 'r', 'z', '{', '|', '}', '~', 127,
+    128, 129, 130, 131, 132, 133, 134, 135, 136, 137, 138, 139, 140, 141, 142, 143,
+    144, 145, 146, 147, 148, 149, 150, 151, 152, 153, 154, 155, 156, 157, 158, 159,
+    160, 161, 162, 163, 164, 165, 166, 167, 168, 169, 170, 171, 172, 173, 174, 175,
+    176, 177, 178, 179, 180, 181, 182, 183, 184, 185, 186, 187, 188, 189, 190, 191,
+    192, 193, 194, 195, 196, 197, 198, 199, 200, 201, 202, 203, 204, 205, 206, 207,
+    208, 209, 210, 211, 212, 213, 214, 215, 216, 217, 218, 219, 220, 221, 222, 223,
+    224, 225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235, 236, 237, 238, 239,
+    240, 241, 242, 243, 244, 245, 246, 247, 248, 249, 250, 251, 252, 253, 254, 255
+};
+
+/**
+ * \brief Reverse the order of the 2-bit fields of a word and complement them.
+ */
+uint64_t cseq_revcomp_word(uint64_t w)
+{
+    w = ((w >> 2) & 0x3333333333333333ULL) | ((w & 0x3333333333333333ULL) << 2);
+    w = ((w >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((w & 0x0f0f0f0f0f0f0f0fULL) << 4);
+    w = ((w >> 8) & 0x00ff00ff00ff00ffULL) | ((w & 0x00ff00ff00ff00ffULL) << 8);
+    w = ((w >> 16) & 0x0000ffff0000ffffULL) | ((w & 0x0000ffff0000ffffULL) << 16);
+    w = (w >> 32) | (w << 32);
+    return ~w;
+}
+
+/**
+ * \brief Replace a compressed sequence by its antisense strand, without copy.
+ *
+ * \param cs    The compressed sequence.
+ */
+void cseq_antisense_inplace(cseq *cs)
+{
+    const unsigned int nwords = (cs->length + CSEQ_WORD - 1) / CSEQ_WORD;
+    const unsigned int pad = nwords * CSEQ_WORD - cs->length;
+    unsigned int i = 0;
+    for (; i < nwords / 2; ++i)
+    {
+        const uint64_t w = cseq_revcomp_word(cs->seq[i]);
+        cs->seq[i] = cseq_revcomp_word(cs->seq[nwords - 1 - i]);
+        cs->seq[nwords - 1 - i] = w;
+    }
+    if (nwords % 2 == 1)
+    {
+        cs->seq[nwords / 2] = cseq_revcomp_word(cs->seq[nwords / 2]);
+    }
+    if (pad > 0)
+    {
+        for (i = 0; i + 1 < nwords; ++i)
+        {
+            cs->seq[i] = (cs->seq[i] >> (2 * pad)) | (cs->seq[i + 1] << (64 - 2 * pad));
+        }
+        cs->seq[nwords - 1] >>= 2 * pad;
+    }
+
+    for (i = 0; i < cs->namb / 2; ++i)
+    {
+        const cseq_run run = cs->amb[i];
+        cs->amb[i] = cs->amb[cs->namb - 1 - i];
+        cs->amb[cs->namb - 1 - i] = run;
+    }
+    /* Runs were stored as 'A' and are now 'T': store them back as 'A'. */
+    unsigned int namb = 0;
+    for (i = 0; i < cs->namb; ++i)
+    {
+        cseq_run run = cs->amb[i];
+        run.pos = cs->length - run.pos - run.length;
+        run.c = (char)iupac_complement[(unsigned char)run.c];
+        /* The complement of 'U' is a nucleotide. */
+        const unsigned char code = cseq_code[(unsigned char)run.c];
+        unsigned int k = run.pos;
+        for (; k < run.pos + run.length; ++k)
+        {
+            cs->seq[k / CSEQ_WORD] &= ~((uint64_t)(3 ^ (code & 3)) << (2 * (k % CSEQ_WORD)));
+        }
+        if (code == 4)
+        {
+            cs->amb[namb++] = run;
+        }
+    }
+    cs->namb = namb;
+}
+
+/**
+ * \brief Return the antisense strand of a compressed sequence.
+ *
+ * Works on whole words: each word is reversed and complemented with a few
+ * shifts and the words are then shifted to remove the padding.
+ *
+ * \param cs    The compressed sequence.
+ * \param dst   A pointer to an unitialized 'cseq' object, set to the antisense strand.
+ */
+void cseq_antisense(const cseq *cs, cseq *dst)
+{
+    cseq_init(dst, cs->length);
+    memcpy(dst->seq, cs->seq, ((cs->length + CSEQ_WORD - 1) / CSEQ_WORD) * sizeof(uint64_t));
+    dst->length = cs->length;
+    unsigned int i = 0;
+    for (; i < cs->namb; ++i)
+    {
+        cseq_insert_run(dst, i, cs->amb[i].pos, cs->amb[i].length, cs->amb[i].c);
+    }
+    cseq_antisense_inplace(dst);
+}
+
+/**
+ * \brief Compare two compressed sequences.
+ *
+ * Same order as strcmp on the decompressed sequences. Whole words are compared
+ * when there are no runs of other residues.
+ *
+ * \param a    A compressed sequence.
+ * \param b    Another compressed sequence.
+ * \return     A negative number, 0 or a positive number if a is before, equal or after b.
+ */
+int cseq_cmp(const cseq *a, const cseq *b)
+{
+    const unsigned int length = (a->length < b->length) ? a->length : b->length;
+    unsigned int i = 0;
+    if (a->namb == 0 && b->namb == 0)
+    {
+        const unsigned int nwords = length / CSEQ_WORD;
+        for (; i < nwords; ++i)
+        {
+            const uint64_t x = a->seq[i] ^ b->seq[i];
+            if (x != 0)
+            {
+                unsigned int k = 0;
+                while (((x >> (2 * k)) & 3) == 0)
+                {
+                    ++k;
+                }
+                return (int)((a->seq[i] >> (2 * k)) & 3) - (int)((b->seq[i] >> (2 * k)) & 3);
+            }
+        }
+        i = nwords * CSEQ_WORD;
+    }
+    for (; i < length; ++i)
+    {
+        const char ca = cseq_get(a, i);
+        const char cb = cseq_get(b, i);
+        if (ca != cb)
+        {
+            return (unsigned char)ca - (unsigned char)cb;
+        }
+    }
+    return (a->length > b->length) - (a->length < b->length);
+}
+
+/**
+ * \brief Number of positions where two sequences of the same length differ.
+ *
+ * One popcount per word, plus a correction for the runs of other residues.
+ *
+ * \param a    A compressed sequence.
+ * \param b    Another compressed sequence of the same length.
+ * \return     The Hamming distance.
+ */
+unsigned int cseq_hamming(const cseq *a, const cseq *b)
+{
+    assert(a->length == b->length);
+    const unsigned int nwords = (a->length + CSEQ_WORD - 1) / CSEQ_WORD;
+    unsigned int d = 0;
+    unsigned int i = 0;
+    for (; i < nwords; ++i)
+    {
+        const uint64_t x = a->seq[i] ^ b->seq[i];
+        d += cseq_popcount((x | (x >> 1)) & 0x5555555555555555ULL);
+    }
+
+    /* Positions in runs: replace the packed comparison by the real one. */
+    const cseq *s[2];
+    s[0] = a;
+    s[1] = b;
+    int j = 0;
+    for (; j < 2; ++j)
+    {
+        for (i = 0; i < s[j]->namb; ++i)
+        {
+            const cseq_run *run = &s[j]->amb[i];
+            unsigned int k = run->pos;
+            for (; k < run->pos + run->length; ++k)
+            {
+                if (j == 1)
+                {
+                    /* Already done if also in a run of a. */
+                    const int r = cseq_find_run(a, k);
+                    if (r >= 0 && k < a->amb[r].pos + a->amb[r].length)
+                    {
+                        continue;
+                    }
+                }
+                const unsigned int shift = 2 * (k % CSEQ_WORD);
+                d -= (((a->seq[k / CSEQ_WORD] ^ b->seq[k / CSEQ_WORD]) >> shift) & 3) != 0;
+                d += cseq_get(a, k) != cseq_get(b, k);
+            }
+        }
+    }
+    return d;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
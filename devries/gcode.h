@@ -0,0 +1,202 @@
+/*! \file
+ *
+ * \brief Genetic codes (the NCBI translation tables).
+ *
+ * A genetic code is compiled once into a 64-entry table indexed like
+ * translation_table in seq.h (16 * first + 4 * second + third nucleotide, with
+ * 'A', 'C', 'G', 'T' = 0, 1, 2, 3), so translating with any code costs the
+ * same as with the default one.
+ */ 
+
+#ifndef GCODE_H_
+#define GCODE_H_
+
+#include <string.h>
+#include "devries.h"
+
+/* For C++ compilers: */
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * \brief A translation table as written by the NCBI (codons in TCAG order, '*' for stops).
+ */
+typedef struct
+{
+    int id; /**< NCBI identifier of the table. */
+
+    const char *name; /**< Name of the table. */
+
+    const char *amino; /**< Amino acid of each codon (TTT, TTC, TTA, TTG, TCT, ...). */
+
+    const char *starts; /**< 'M' for initiation codons. */
+}
+ncbi_code;
+
+/**
+ * \brief The NCBI translation tables.
+ */
+static const ncbi_code ncbi_codes[] =
+{
+    {1, "Standard",
+     "FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "---M------**--*----M---------------M----------------------------"},
+    {2, "Vertebrate Mitochondrial",
+     "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSS**VVVVAAAADDEEGGGG",
+     "----------**--------------------MMMM----------**---M------------"},
+    {3, "Yeast Mitochondrial",
+     "FFLLSSSSYY**CCWWTTTTPPPPHHQQRRRRIIMMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "----------**----------------------MM---------------M------------"},
+    {4, "Mold, Protozoan, and Coelenterate Mitochondrial and Mycoplasma/Spiroplasma",
+     "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "--MM------**-------M------------MMMM---------------M------------"},
+    {5, "Invertebrate Mitochondrial",
+     "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSSSSVVVVAAAADDEEGGGG",
+     "---M------**--------------------MMMM---------------M------------"},
+    {6, "Ciliate, Dasycladacean and Hexamita Nuclear",
+     "FFLLSSSSYYQQCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "--------------*--------------------M----------------------------"},
+    {9, "Echinoderm and Flatworm Mitochondrial",
+     "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNNKSSSSVVVVAAAADDEEGGGG",
+     "----------**-----------------------M---------------M------------"},
+    {10, "Euplotid Nuclear",
+     "FFLLSSSSYY**CCCWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "----------**-----------------------M----------------------------"},
+    {11, "Bacterial, Archaeal and Plant Plastid",
+     "FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "---M------**--*----M------------MMMM---------------M------------"},
+    {12, "Alternative Yeast Nuclear",
+     "FFLLSSSSYY**CC*WLLLSPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "----------**--*----M---------------M----------------------------"},
+    {13, "Ascidian Mitochondrial",
+     "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSSGGVVVVAAAADDEEGGGG",
+     "---M------**----------------------MM---------------M------------"},
+    {14, "Alternative Flatworm Mitochondrial",
+     "FFLLSSSSYYY*CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNNKSSSSVVVVAAAADDEEGGGG",
+     "-----------*-----------------------M----------------------------"},
+    {15, "Blepharisma Macronuclear",
+     "FFLLSSSSYY*QCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "----------*---*--------------------M----------------------------"},
+    {16, "Chlorophycean Mitochondrial",
+     "FFLLSSSSYY*LCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "----------*---*--------------------M----------------------------"},
+    {21, "Trematode Mitochondrial",
+     "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNNKSSSSVVVVAAAADDEEGGGG",
+     "----------**-----------------------M---------------M------------"},
+    {22, "Scenedesmus obliquus Mitochondrial",
+     "FFLLSS*SYY*LCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "------*---*---*--------------------M----------------------------"},
+    {23, "Thraustochytrium Mitochondrial",
+     "FF*LSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "--*-------**--*-----------------M--M---------------M------------"},
+    {24, "Rhabdopleuridae Mitochondrial",
+     "FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSSKVVVVAAAADDEEGGGG",
+     "---M------**-------M---------------M---------------M------------"},
+    {25, "Candidate Division SR1 and Gracilibacteria",
+     "FFLLSSSSYY**CCGWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "---M------**-----------------------M---------------M------------"},
+    {26, "Pachysolen tannophilus Nuclear",
+     "FFLLSSSSYY**CC*WLLLAPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "----------**--*----M---------------M----------------------------"},
+    {27, "Karyorelictid Nuclear",
+     "FFLLSSSSYYQQCCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "-----------------------------------M----------------------------"},
+    {28, "Condylostoma Nuclear",
+     "FFLLSSSSYYQQCCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "-----------------------------------M----------------------------"},
+    {29, "Mesodinium Nuclear",
+     "FFLLSSSSYYYYCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "--------------*--------------------M----------------------------"},
+    {30, "Peritrich Nuclear",
+     "FFLLSSSSYYEECC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "--------------*--------------------M----------------------------"},
+    {31, "Blastocrithidia Nuclear",
+     "FFLLSSSSYYEECCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "-----------------------------------M----------------------------"},
+    {32, "Balanophoraceae Plastid",
+     "FFLLSSSSYY*WCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG",
+     "---M------*---*----M------------MMMM---------------M------------"},
+    {33, "Cephalodiscidae Mitochondrial",
+     "FFLLSSSSYYY*CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSSKVVVVAAAADDEEGGGG",
+     "---M-------*-------M---------------M---------------M------------"}
+};
+
+/**
+ * \brief Number of NCBI translation tables.
+ */
+#define NCBI_NCODES (sizeof(ncbi_codes) / sizeof(ncbi_codes[0]))
+
+/**
+ * \brief A genetic code ready for translation.
+ */
+typedef struct
+{
+    int id; /**< NCBI identifier of the table (0 for a custom code). */
+
+    const char *name; /**< Name of the code. */
+
+    char table[64]; /**< Amino acid of each codon, 'Z' for stops. */
+
+    char start[64]; /**< TRUE for initiation codons. */
+}
+genetic_code;
+
+/**
+ * \brief Initialize a genetic code from 64 amino acids and starts in NCBI (TCAG) order.
+ *
+ * \param code      A pointer to an unitialized 'genetic_code' object.
+ * \param amino     Amino acid of each codon ('*' or 'Z' for stops).
+ * \param starts    'M' for initiation codons (NULL for ATG only).
+ */
+void genetic_code_compile(genetic_code *code, const char *amino, const char *starts)
+{
+    /* Position of 'A', 'C', 'G' and 'T' in TCAG. */
+    static const int tcag[4] = {2, 1, 3, 0};
+    int i, j, k;
+    for (i = 0; i < 4; ++i)
+    {
+        for (j = 0; j < 4; ++j)
+        {
+            for (k = 0; k < 4; ++k)
+            {
+                const int ncbi = 16 * tcag[i] + 4 * tcag[j] + tcag[k];
+                const int index = 16 * i + 4 * j + k;
+                code->table[index] = (amino[ncbi] == '*') ? 'Z' : amino[ncbi];
+                code->start[index] = (starts != NULL) ? (starts[ncbi] == 'M') : (index == 14);
+            }
+        }
+    }
+    code->id = 0;
+    code->name = "Custom";
+}
+
+/**
+ * \brief Initialize one of the NCBI genetic codes.
+ *
+ * \param code    A pointer to an unitialized 'genetic_code' object.
+ * \param id      NCBI identifier of the table (1 for the standard code, 2 for vertebrate mitochondria, ...).
+ * \return        TRUE if the table exists, FALSE otherwise.
+ */
+int genetic_code_init(genetic_code *code, int id)
+{
+    unsigned int i = 0;
+    for (; i < NCBI_NCODES; ++i)
+    {
+        if (ncbi_codes[i].id == id)
+        {
+            genetic_code_compile(code, ncbi_codes[i].amino, ncbi_codes[i].starts);
+            code->id = id;
+            code->name = ncbi_codes[i].name;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -10,11 +10,15 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <stdint.h>
+#include <math.h>
 #include <libxml/parser.h>
 #include "devries.h"
 #include "tnode.h"
 #include "sll.h"
+#include "rope.h"
 #include "seq.h"
+#include "well1024.h"
 
 /* For C++ compilers: */
 #ifdef __cplusplus
@@ -71,23 +75,67 @@ typedef struct
 mutation_tree;
 
 /**
- * \brief Build the complete sequence for a node of the tree.
+ * \brief Apply a point mutation to a sequence.
  *
- * This function will apply the mutations from this node to the root of the
- * mutation tree to generate a sequence.
+ * \param seq     A pointer to the sequence.
+ * \param mut     Mutation object.
+ */
+void apply_point(char *seq, mutation *m)
+{
+    seq[m->pos] = m->mut.newc;
+}
+
+/**
+ * \brief Apply an insert mutation.
  *
- * \param node    Node of the mutation tree.
- * \return        Sequence.
+ * This function will reallocate memory to accomodate the new elements.
+ *
+ * \param seq     A pointer to the sequence.
+ * \param mut     Mutation object.
+ * \return        A pointer to the new sequence.
  */
-char *get_sequence(tnode *node);
+char *apply_insert(char **seq, mutation *m)
+{
+    const size_t length = strlen(*seq);
+    const size_t insert_length = strlen(m->mut.insert);
+    *seq = (char*)realloc(*seq, length + insert_length + 1);
+    memmove(*seq + m->pos + insert_length, *seq + m->pos, length - m->pos + 1);
+    memcpy(*seq + m->pos, m->mut.insert, insert_length);
+    return *seq;
+}
 
 /**
- * \brief Create a singly linked list of all mutations in and under the node.
+ * \brief Apply a del mutation.
  *
- * \param node    Node of the mutation tree.
- * \return        Singly-linked list with all mutations.
+ * This function will *not* reallocate memory (see apply_del_realloc). 
+ * 
+ * \param seq     A pointer to the sequence.
+ * \param mut     Mutation object.
+ * \return        A pointer to the sequence.
+ */
+char *apply_del(char **seq, mutation *m)
+{
+    const size_t length = strlen(*seq);
+    assert(m->pos + m->mut.ndels <= length);
+    memmove(*seq + m->pos, *seq + m->pos + m->mut.ndels, length - m->pos - m->mut.ndels + 1);
+    return *seq;
+}
+
+/**
+ * \brief Apply a del mutation.
+ *
+ * Reallocate memory. Save space but is less efficient than apply_del.
+ * 
+ * \param seq     A pointer to the sequence.
+ * \param mut     Mutation object.
+ * \return        A pointer to the sequence.
  */
-sll *list_mutations(tnode *node);
+char *apply_del_realloc(char **seq, mutation *m)
+{
+    apply_del(seq, m);
+    *seq = (char*)realloc(*seq, strlen(*seq) + 1);
+    return *seq;
+}
 
 /**
  * \brief Apply a mutation to a sequence.
@@ -100,52 +148,172 @@ sll *list_mutations(tnode *node);
  * \param mut     Mutation object.
  * \return        A pointer to the sequence (will only change if memory has been reallocated).
  */
-char *apply_mut(char **seq, mutation *m);
+char *apply_mut(char **seq, mutation *m)
+{
+    if (m->type == Point)
+    {
+        apply_point(*seq, m);
+        return *seq;
+    }
+    if (m->type == Insertions)
+    {
+        return apply_insert(seq, m);
+    }
+    return apply_del(seq, m);
+}
 
 /**
- * \brief Apply a point mutation to a sequence.
+ * \brief Apply a mutation to a rope, O(log p) for p pieces.
  *
- * \param seq     A pointer to the sequence.
+ * Unlike apply_mut, the cost doesn't depend on the length of the sequence:
+ * prefer it to replay many mutations, then flatten the rope once.
+ *
+ * \param r       The rope.
  * \param mut     Mutation object.
- * \return        A pointer to the sequence (will only change if memory has been reallocated).
  */
-void apply_point(char *seq, mutation *m);
+void apply_mut_rope(rope *r, const mutation *m)
 {
-    seq[mut->pos] = mut->newc;
+    if (m->type == Point)
+    {
+        rope_set(r, m->pos, m->mut.newc);
+    }
+    else if (m->type == Insertions)
+    {
+        rope_insert(r, m->pos, m->mut.insert, strlen(m->mut.insert));
+    }
+    else
+    {
+        rope_delete(r, m->pos, m->mut.ndels);
+    }
 }
 
 /**
- * \brief Apply an insert mutation.
- *
- * This function will reallocate memory to accomodate the new elements.
+ * \brief Length of a sequence once a batch of mutations is applied.
  *
- * \param seq     A pointer to the sequence.
- * \param mut     Mutation object.
- * \return        A pointer to the new sequence.
+ * \param length  Length of the sequence.
+ * \param muts    The mutations, in application order.
+ * \param n       Number of mutations.
+ * \return        Length of the mutated sequence.
  */
-char *apply_insert(char **seq, mutation *m);
+size_t apply_mut_batch_length(size_t length, mutation * const *muts, size_t n)
+{
+    size_t i = 0;
+    for (; i < n; ++i)
+    {
+        if (muts[i]->type == Insertions)
+        {
+            length += strlen(muts[i]->mut.insert);
+        }
+        else if (muts[i]->type == Deletions)
+        {
+            assert(muts[i]->mut.ndels <= length);
+            length -= muts[i]->mut.ndels;
+        }
+    }
+    return length;
+}
 
 /**
- * \brief Apply a del mutation.
+ * \brief Apply a batch of mutations in a single pass.
  *
- * This function will *not* reallocate memory (see apply_del_realloc). 
- * 
- * \param seq     A pointer to the sequence.
- * \param mut     Mutation object.
- * \return        A pointer to the sequence.
+ * When the positions decrease along the list and no mutation touches a site
+ * at or after the position of the one applied before it (the lists built by
+ * mutation_tree_simulate almost always are like this), all coordinates are
+ * already those of the original sequence. The result is then written in one
+ * left-to-right sweep, O(n + m). Otherwise the coordinates are resolved in
+ * application order on a rope, O(m log m), then flattened in one sweep.
+ * Either way no memory is moved or reallocated per mutation.
+ *
+ * \param seq     The sequence (not modified).
+ * \param length  Length of the sequence.
+ * \param muts    The (valid) mutations, in application order.
+ * \param n       Number of mutations.
+ * \param dst     Where to write the apply_mut_batch_length + 1 residues
+ *                (NUL-terminated, must not overlap 'seq').
+ * \return        Length of the mutated sequence.
  */
-char *apply_del(char **seq, mutation *m);
+size_t apply_mut_batch(const char *seq, size_t length, mutation * const *muts, size_t n, char *dst)
+{
+    size_t i = 1;
+    for (; i < n; ++i)
+    {
+        const mutation *m = muts[i];
+        const size_t end = m->pos + ((m->type == Point) ? 1 : (m->type == Deletions) ? m->mut.ndels : 0);
+        if (end > muts[i - 1]->pos)
+        {
+            break;
+        }
+    }
+
+    if (i < n)
+    {
+        rope r;
+        rope_init(&r, seq, length);
+        for (i = 0; i < n; ++i)
+        {
+            apply_mut_rope(&r, muts[i]);
+        }
+        length = rope_length(&r);
+        rope_flatten(&r, dst);
+        rope_free(&r);
+        return length;
+    }
+
+    char *out = dst;
+    size_t src = 0;
+    for (i = n; i-- > 0;)
+    {
+        const mutation *m = muts[i];
+        assert(m->pos >= src && m->pos <= length);
+        memcpy(out, seq + src, m->pos - src);
+        out += m->pos - src;
+        src = m->pos;
+        if (m->type == Point)
+        {
+            *out++ = m->mut.newc;
+            ++src;
+        }
+        else if (m->type == Insertions)
+        {
+            const size_t insert_length = strlen(m->mut.insert);
+            memcpy(out, m->mut.insert, insert_length);
+            out += insert_length;
+        }
+        else
+        {
+            src += m->mut.ndels;
+        }
+    }
+    assert(src <= length);
+    memcpy(out, seq + src, length - src);
+    out += length - src;
+    *out = '\0';
+    return out - dst;
+}
 
 /**
- * \brief Apply a del mutation.
+ * \brief Return a sequence with a list of mutations applied (see apply_mut_batch).
  *
- * Reallocate memory. Save space but is less efficient than apply_del.
- * 
- * \param seq     A pointer to the sequence.
- * \param mut     Mutation object.
- * \return        A pointer to the sequence.
+ * \param seq     The sequence (not modified).
+ * \param l       Singly linked list of mutations, in application order.
+ * \return        A new sequence (to free with free).
  */
-char *apply_del_realloc(char **seq, mutation *m);
+char *apply_mut_list(const char *seq, const sll *l)
+{
+    const size_t n = sll_length(l);
+    mutation **muts = (mutation**)malloc((n > 0 ? n : 1) * sizeof(mutation*));
+    size_t i = 0;
+    sllnode *node = l->head;
+    for (; node != NULL; node = node->next)
+    {
+        muts[i++] = (mutation*)node->data;
+    }
+    const size_t length = strlen(seq);
+    char *dst = (char*)malloc(apply_mut_batch_length(length, muts, n) + 1);
+    apply_mut_batch(seq, length, muts, n, dst);
+    free(muts);
+    return dst;
+}
 
 /**
  * \brief Return a mutated sequence without modifying the original.
@@ -156,13 +324,13 @@ char *apply_del_realloc(char **seq, mutation *m);
  */
 char* get_mut(const char *seq, mutation *m)
 {
-    unsigned int length0 = len(seq);
+    const unsigned int length0 = strlen(seq);
     unsigned int length1 = length0;
     if (m->type == Insertions)
     {
         length1 += strlen(m->mut.insert);
     }
-    else if (m->type = Deletions)
+    else if (m->type == Deletions)
     {
         length1 -= m->mut.ndels;
     }
@@ -170,25 +338,951 @@ char* get_mut(const char *seq, mutation *m)
 
     if (m->type == Point)
     {
-        memcpy(seq1, seq, length);
-        seq1[mut->pos] = mut->newc;
+        memcpy(seq1, seq, length0);
+        seq1[m->pos] = m->mut.newc;
     }
-    if (m->type == Inserts)
+    else if (m->type == Insertions)
     {
         const unsigned int insert_length = strlen(m->mut.insert);
         memcpy(seq1, seq, m->pos);
         memcpy(seq1 + m->pos, m->mut.insert, insert_length);
-        memcpy(seq1 + m->pos + insert_length, seq, length - m->pos);
+        memcpy(seq1 + m->pos + insert_length, seq + m->pos, length0 - m->pos);
     }
     else /* Delete. */
     {
         memcpy(seq1, seq, m->pos);
-        memcpy(seq1 + m->pos, seq, length - m->pos);
+        memcpy(seq1 + m->pos, seq + m->pos + m->mut.ndels, length1 - m->pos);
     }
     seq1[length1] = '\0';
     return seq1;
 }
 
+/**
+ * \brief Free a mutation (and its insert). Can be used as a sll destructor.
+ *
+ * \param m       The mutation.
+ */
+void mutation_free(void *m)
+{
+    mutation *mut = (mutation*)m;
+    if (mut->type == Insertions)
+    {
+        free(mut->mut.insert);
+    }
+    free(mut);
+}
+
+/**
+ * \brief Rates of the mutation model, per site and per unit of branch length.
+ *
+ * Point mutations follow Jukes-Cantor: an event draws the new nucleotide
+ * uniformly among the four (a quarter of the events are silent), so the
+ * ancestral sequence is never needed. The length of an indel is 1 plus a
+ * geometric number of extensions.
+ */
+typedef struct
+{
+    double point; /**< Rate of point mutations. */
+
+    double insertion; /**< Rate of insertions (per gap between sites). */
+
+    double deletion; /**< Rate of deletions. */
+
+    double ins_extend; /**< Probability to extend an insertion by one nucleotide. */
+
+    double del_extend; /**< Probability to extend a deletion by one nucleotide. */
+}
+mutation_rates;
+
+/**
+ * \brief Order mutations by decreasing position.
+ *
+ * At the same position a point mutation comes first, then a deletion, then an
+ * insertion: the deletion never removes the inserted residues, and a deletion
+ * followed by an insertion is still accepted by the sweep of apply_mut_batch.
+ */
+int mutation_cmp_desc(const void *a, const void *b)
+{
+    static const int rank[3] = { 0, 2, 1 }; /* Point, Insertions, Deletions */
+    const mutation *ma = *(mutation* const*)a;
+    const mutation *mb = *(mutation* const*)b;
+    if (ma->pos != mb->pos)
+    {
+        return (ma->pos < mb->pos) ? 1 : -1;
+    }
+    return rank[ma->type] - rank[mb->type];
+}
+
+/**
+ * \brief Buffer of mutations reused from one branch to the next.
+ */
+typedef struct
+{
+    mutation **muts; /**< The mutations of the current branch. */
+
+    size_t n; /**< Number of mutations. */
+
+    size_t capacity; /**< Capacity of the buffer. */
+}
+mutation_buffer;
+
+/**
+ * \brief Append a mutation to the buffer.
+ *
+ * \param buf     The buffer.
+ * \param type    Type of the mutation.
+ * \param pos     Position of the mutation.
+ * \return        The new mutation (details to fill).
+ */
+mutation *mutation_buffer_add(mutation_buffer *buf, mut_type type, uint64_t pos)
+{
+    if (buf->n == buf->capacity)
+    {
+        buf->capacity = (buf->capacity == 0) ? 64 : 2 * buf->capacity;
+        buf->muts = (mutation**)realloc(buf->muts, buf->capacity * sizeof(mutation*));
+    }
+    mutation *m = (mutation*)malloc(sizeof(mutation));
+    m->type = type;
+    m->pos = (unsigned int)pos;
+    buf->muts[buf->n++] = m;
+    return m;
+}
+
+/**
+ * \brief Draw the mutations of one branch.
+ *
+ * Each type of mutation hits a site with probability 1 - exp(-rate * t); the
+ * hits are found by skip sampling, so the cost is proportional to the number of
+ * mutations, not to the length of the sequence. The mutations are appended to
+ * the list by decreasing position, all positions being in the coordinates of
+ * the parent: applied in the order of the list, no mutation shifts the
+ * positions of the ones still to apply.
+ *
+ * \param rng      A random number generator.
+ * \param rates    The mutation model.
+ * \param length   Length of the parent sequence.
+ * \param t        Length of the branch.
+ * \param buf      A buffer (reused between calls, empty on return).
+ * \param list     List where to append the mutations.
+ * \return         Length of the sequence at the end of the branch.
+ */
+uint64_t mutation_simulate_branch(well1024 *rng, const mutation_rates *rates, uint64_t length, double t, mutation_buffer *buf, sll *list)
+{
+    uint64_t i;
+    if (t <= 0.0)
+    {
+        return length;
+    }
+    if (rates->point > 0.0)
+    {
+        const double p = -expm1(-rates->point * t);
+        for (i = well1024_next_site(rng, 0, p); i < length; i = well1024_next_site(rng, i + 1, p))
+        {
+            mutation_buffer_add(buf, Point, i)->mut.newc = "ACGT"[well1024_next_uint32(rng) >> 30];
+        }
+    }
+    if (rates->insertion > 0.0)
+    {
+        const double p = -expm1(-rates->insertion * t);
+        for (i = well1024_next_site(rng, 0, p); i <= length; i = well1024_next_site(rng, i + 1, p))
+        {
+            const uint64_t n = 1 + well1024_next_geometric(rng, 1.0 - rates->ins_extend);
+            char *insert = (char*)malloc(n + 1);
+            nuc_random_fill(rng, insert, n, "ACGT");
+            insert[n] = '\0';
+            mutation_buffer_add(buf, Insertions, i)->mut.insert = insert;
+        }
+    }
+    if (rates->deletion > 0.0)
+    {
+        const double p = -expm1(-rates->deletion * t);
+        for (i = well1024_next_site(rng, 0, p); i < length; i = well1024_next_site(rng, i + 1, p))
+        {
+            const uint64_t n = 1 + well1024_next_geometric(rng, 1.0 - rates->del_extend);
+            mutation_buffer_add(buf, Deletions, i)->mut.ndels = (n > UINT_MAX) ? UINT_MAX : (unsigned int)n;
+        }
+    }
+
+    qsort(buf->muts, buf->n, sizeof(mutation*), mutation_cmp_desc);
+    for (i = 0; i < buf->n; ++i)
+    {
+        mutation *m = buf->muts[i];
+        if (m->type == Insertions)
+        {
+            length += strlen(m->mut.insert);
+        }
+        else if (m->type == Deletions)
+        {
+            /* Sites on the right were already handled, only clip at the end. */
+            if (m->mut.ndels > length - m->pos)
+            {
+                m->mut.ndels = (unsigned int)(length - m->pos);
+            }
+            length -= m->mut.ndels;
+        }
+        sll_add_tail(list, m);
+    }
+    buf->n = 0;
+    return length;
+}
+
+/**
+ * \brief Free the lists of mutations attached to the nodes of the tree.
+ *
+ * \param mt      The mutation tree.
+ */
+void mutation_tree_clear(mutation_tree *mt)
+{
+    size_t capacity = 64;
+    size_t top = 0;
+    tnode **stack = (tnode**)malloc(capacity * sizeof(tnode*));
+    stack[top++] = mt->root;
+    while (top > 0)
+    {
+        tnode *node = stack[--top];
+        sllnode *n = node->children.head;
+        for (; n != NULL; n = n->next)
+        {
+            if (top == capacity)
+            {
+                capacity *= 2;
+                stack = (tnode**)realloc(stack, capacity * sizeof(tnode*));
+            }
+            stack[top++] = (tnode*)(n->data);
+        }
+        if (node->data != NULL)
+        {
+            sll_rm_all((sll*)node->data);
+            free(node->data);
+            node->data = NULL;
+        }
+    }
+    free(stack);
+}
+
+/**
+ * \brief Evolve the root sequence along the tree.
+ *
+ * The 'data' of every node is set to a new list (sll of 'mutation*', owning
+ * them) of the mutations on the branch leading to that node, the list of the
+ * root being empty. Previous data is overwritten, not freed. The tree is walked
+ * with an explicit stack that only carries sequence lengths, so large trees
+ * (millions of tips, any depth) need no sequence and no recursion.
+ *
+ * \param mt       The mutation tree (root sequence and topology with branch lengths).
+ * \param rates    The mutation model.
+ * \param rng      A random number generator.
+ * \return         The total number of mutations.
+ */
+uint64_t mutation_tree_simulate(mutation_tree *mt, const mutation_rates *rates, well1024 *rng)
+{
+    typedef struct
+    {
+        tnode *node;
+        uint64_t length; /* Length of the parent sequence. */
+    }
+    frame;
+
+    uint64_t nmuts = 0;
+    mutation_buffer buf = {NULL, 0, 0};
+    size_t capacity = 64;
+    size_t top = 0;
+    frame *stack = (frame*)malloc(capacity * sizeof(frame));
+
+    assert(rates->ins_extend >= 0.0 && rates->ins_extend < 1.0);
+    assert(rates->del_extend >= 0.0 && rates->del_extend < 1.0);
+
+    stack[top].node = mt->root;
+    stack[top++].length = strlen(mt->seq);
+    while (top > 0)
+    {
+        const frame f = stack[--top];
+        sll *list = (sll*)malloc(sizeof(sll));
+        sll_init(list, mutation_free);
+        f.node->data = list;
+
+        uint64_t length = f.length;
+        if (f.node != mt->root)
+        {
+            length = mutation_simulate_branch(rng, rates, f.length, f.node->length, &buf, list);
+            nmuts += sll_length(list);
+        }
+        assert(length <= UINT_MAX);
+
+        sllnode *n = f.node->children.head;
+        for (; n != NULL; n = n->next)
+        {
+            if (top == capacity)
+            {
+                capacity *= 2;
+                stack = (frame*)realloc(stack, capacity * sizeof(frame));
+            }
+            stack[top].node = (tnode*)(n->data);
+            stack[top++].length = length;
+        }
+    }
+    free(stack);
+    free(buf.muts);
+    return nmuts;
+}
+
+/**
+ * \brief Apply the mutations of a node (its list in 'data', may be NULL).
+ *
+ * The list is applied as a batch, so the sequence is rebuilt only once.
+ *
+ * \param seq     A pointer to the sequence.
+ * \param node    Node of the mutation tree.
+ * \return        Number of mutations applied.
+ */
+size_t apply_node_mutations(char **seq, const tnode *node)
+{
+    if (node->data == NULL || ((sll*)node->data)->head == NULL)
+    {
+        return 0;
+    }
+    char *mutated = apply_mut_list(*seq, (sll*)node->data);
+    free(*seq);
+    *seq = mutated;
+    return sll_length((sll*)node->data);
+}
+
+/**
+ * \brief Build the complete sequence for a node of the tree.
+ *
+ * This function will apply the mutations from the root of the mutation tree to
+ * this node to generate a sequence. The mutations are replayed on a rope, so the
+ * cost is O(k log k + n) for k mutations and a sequence of length n (see
+ * 'mutation_cache' to avoid starting from the root every time).
+ *
+ * \param mt      The mutation tree.
+ * \param node    Node of the mutation tree.
+ * \return        Sequence (to free with free).
+ */
+char *get_sequence(const mutation_tree *mt, tnode *node)
+{
+    size_t n = 0;
+    tnode **path = tnode_path(node, &n);
+    rope r;
+    rope_init(&r, mt->seq, strlen(mt->seq));
+    while (n > 0)
+    {
+        const tnode *t = path[--n];
+        if (t->data != NULL)
+        {
+            sllnode *l = ((sll*)t->data)->head;
+            for (; l != NULL; l = l->next)
+            {
+                apply_mut_rope(&r, (mutation*)l->data);
+            }
+        }
+    }
+    free(path);
+    char *seq = rope_to_string(&r);
+    rope_free(&r);
+    return seq;
+}
+
+/**
+ * \brief Create a singly linked list of all mutations from the root to the node.
+ *
+ * The mutations are in the order in which they have to be applied to the
+ * sequence of the mutation tree. The list doesn't own them.
+ *
+ * \param node    Node of the mutation tree.
+ * \return        Singly-linked list with all mutations (to free with sll_free and free).
+ */
+sll *list_mutations(tnode *node)
+{
+    size_t n = 0;
+    tnode **path = tnode_path(node, &n);
+    sll *l = (sll*)malloc(sizeof(sll));
+    sll_init(l, NULL);
+    while (n > 0)
+    {
+        const tnode *t = path[--n];
+        if (t->data != NULL)
+        {
+            sllnode *m = ((sll*)t->data)->head;
+            for (; m != NULL; m = m->next)
+            {
+                sll_add_tail(l, m->data);
+            }
+        }
+    }
+    free(path);
+    return l;
+}
+
+/**
+ * \brief Maximum number of counters of nodes not cached (CacheFrequency).
+ *
+ * When there are more, the counters of the nodes not cached are dropped and
+ * those of the cached nodes are halved, so the table never grows with the
+ * number of nodes visited and old counts fade.
+ */
+#define MUTATION_CACHE_MAX_COUNTERS 65536
+
+/**
+ * \brief How the materialization cache chooses its checkpoints.
+ */
+typedef enum
+{
+    CacheStride = 0, /**< Every node whose depth is a multiple of the stride. */
+    CacheFrequency = 1, /**< The nodes most often on the way to requested nodes. */
+}
+mutation_cache_policy;
+
+/**
+ * \brief A node known by the cache.
+ */
+typedef struct
+{
+    tnode *node; /**< The node (NULL for an empty slot). */
+
+    unsigned int depth; /**< Depth of the node. */
+
+    uint64_t count; /**< Number of reconstructions through the node. */
+
+    int cached; /**< 1 (TRUE) if the sequence of the node is cached. */
+
+    char *seq; /**< The sequence (if cached and not packed, NULL if packed). */
+
+    cseq packed; /**< The 2-bit sequence (if cached and packed). */
+
+    size_t memory; /**< Bytes used by the cached sequence. */
+}
+mutation_cache_entry;
+
+/**
+ * \brief Materialization cache for the sequences of a mutation tree.
+ *
+ * Sequences are stored at checkpoint nodes, so a reconstruction starts from the
+ * nearest cached ancestor instead of the root. With CacheStride, the nodes at
+ * depths multiple of 'stride' are stored the first time they are built (until
+ * the budget is full). With CacheFrequency, a node is stored when it is on the
+ * way to a requested node for the second time; once the budget is full it
+ * replaces the least used cached node, if that one is used less (see
+ * MUTATION_CACHE_MAX_COUNTERS for the counters).
+ */
+typedef struct
+{
+    const mutation_tree *mt; /**< The mutation tree. */
+
+    mutation_cache_policy policy; /**< How the checkpoints are chosen. */
+
+    unsigned int stride; /**< Depth between checkpoints (CacheStride). */
+
+    size_t budget; /**< Maximum number of bytes of cached sequences (0 for no limit). */
+
+    int packed; /**< 1 (TRUE) to store 2-bit sequences, see 'cseq'. */
+
+    mutation_cache_entry *table; /**< Open addressing hash table of entries. */
+
+    size_t capacity; /**< Number of slots in the table (a power of 2). */
+
+    size_t size; /**< Number of entries in the table. */
+
+    tnode **cached; /**< The cached nodes. */
+
+    size_t ncached; /**< Number of cached nodes. */
+
+    size_t cached_capacity; /**< Capacity of 'cached'. */
+
+    size_t memory; /**< Bytes used by the cached sequences. */
+
+    uint64_t hits; /**< Reconstructions started from a cached node. */
+
+    uint64_t misses; /**< Reconstructions started from the root. */
+
+    uint64_t applied; /**< Mutations applied. */
+
+    uint64_t stored; /**< Sequences stored. */
+
+    uint64_t evicted; /**< Sequences evicted. */
+}
+mutation_cache;
+
+/**
+ * \brief Initialize a materialization cache.
+ *
+ * \param c         A pointer to an unitialized 'mutation_cache' object.
+ * \param mt        The mutation tree (must outlive the cache).
+ * \param policy    How the checkpoints are chosen.
+ * \param stride    Depth between checkpoints (only for CacheStride).
+ * \param budget    Maximum number of bytes of cached sequences (0 for no limit).
+ * \param packed    1 (TRUE) to store 2-bit sequences (ambiguous residues are
+ *                  kept, sequences with lowercase nucleotides are not packed).
+ */
+void mutation_cache_init(mutation_cache *c, const mutation_tree *mt, mutation_cache_policy policy, unsigned int stride, size_t budget, int packed)
+{
+    assert(policy != CacheStride || stride > 0);
+    c->mt = mt;
+    c->policy = policy;
+    c->stride = stride;
+    c->budget = budget;
+    c->packed = packed;
+    c->capacity = 64;
+    c->size = 0;
+    c->table = (mutation_cache_entry*)calloc(c->capacity, sizeof(mutation_cache_entry));
+    c->cached_capacity = 16;
+    c->ncached = 0;
+    c->cached = (tnode**)malloc(c->cached_capacity * sizeof(tnode*));
+    c->memory = 0;
+    c->hits = 0;
+    c->misses = 0;
+    c->applied = 0;
+    c->stored = 0;
+    c->evicted = 0;
+}
+
+/**
+ * \brief Free the memory of the cache (not the mutation tree).
+ *
+ * \param c     The cache.
+ */
+void mutation_cache_free(mutation_cache *c)
+{
+    size_t i = 0;
+    for (; i < c->capacity; ++i)
+    {
+        if (c->table[i].cached)
+        {
+            if (c->table[i].seq == NULL)
+            {
+                cseq_free(&c->table[i].packed);
+            }
+            free(c->table[i].seq);
+        }
+    }
+    free(c->table);
+    free(c->cached);
+    c->table = NULL;
+    c->cached = NULL;
+}
+
+/**
+ * \brief Slot of a node in the table (empty if the node is unknown).
+ */
+size_t mutation_cache_slot(const mutation_cache *c, const tnode *node)
+{
+    size_t i = (size_t)(((uint64_t)(uintptr_t)node * 0x9E3779B97F4A7C15ULL) >> 20) & (c->capacity - 1);
+    while (c->table[i].node != NULL && c->table[i].node != node)
+    {
+        i = (i + 1) & (c->capacity - 1);
+    }
+    return i;
+}
+
+/**
+ * \brief Entry of a node, NULL if the node is unknown.
+ */
+mutation_cache_entry *mutation_cache_find(const mutation_cache *c, const tnode *node)
+{
+    mutation_cache_entry *e = c->table + mutation_cache_slot(c, node);
+    return (e->node == NULL) ? NULL : e;
+}
+
+/**
+ * \brief Entry of a node, added if needed (entries move when the table grows
+ * or is pruned, see MUTATION_CACHE_MAX_COUNTERS).
+ */
+mutation_cache_entry *mutation_cache_entry_get(mutation_cache *c, tnode *node, unsigned int depth)
+{
+    size_t i = mutation_cache_slot(c, node);
+    if (c->table[i].node != NULL)
+    {
+        return c->table + i;
+    }
+    if (2 * (c->size + 1) > c->capacity)
+    {
+        /* Prune instead of growing when there are too many counters. */
+        const int prune = (c->size - c->ncached >= MUTATION_CACHE_MAX_COUNTERS);
+        mutation_cache_entry *old = c->table;
+        const size_t old_capacity = c->capacity;
+        if (!prune)
+        {
+            c->capacity *= 2;
+        }
+        c->table = (mutation_cache_entry*)calloc(c->capacity, sizeof(mutation_cache_entry));
+        c->size = 0;
+        for (i = 0; i < old_capacity; ++i)
+        {
+            if (old[i].node != NULL && (!prune || old[i].cached))
+            {
+                if (prune)
+                {
+                    old[i].count /= 2;
+                }
+                c->table[mutation_cache_slot(c, old[i].node)] = old[i];
+                ++c->size;
+            }
+        }
+        free(old);
+        i = mutation_cache_slot(c, node);
+    }
+    ++c->size;
+    c->table[i].node = node;
+    c->table[i].depth = depth;
+    return c->table + i;
+}
+
+/**
+ * \brief Store a sequence, or its 2-bit copy if 'packed' is not NULL (the entry takes it over).
+ */
+void mutation_cache_store(mutation_cache *c, mutation_cache_entry *e, const char *seq, size_t length, cseq *packed, size_t memory)
+{
+    if (packed != NULL)
+    {
+        e->packed = *packed;
+        e->seq = NULL;
+    }
+    else
+    {
+        e->seq = (char*)malloc(length + 1);
+        memcpy(e->seq, seq, length + 1);
+    }
+    e->memory = memory;
+    e->cached = TRUE;
+    c->memory += e->memory;
+    ++c->stored;
+    if (c->ncached == c->cached_capacity)
+    {
+        c->cached_capacity *= 2;
+        c->cached = (tnode**)realloc(c->cached, c->cached_capacity * sizeof(tnode*));
+    }
+    c->cached[c->ncached++] = e->node;
+}
+
+/**
+ * \brief Evict the i-th cached node.
+ */
+void mutation_cache_evict(mutation_cache *c, size_t i)
+{
+    mutation_cache_entry *e = mutation_cache_find(c, c->cached[i]);
+    if (e->seq == NULL)
+    {
+        cseq_free(&e->packed);
+    }
+    free(e->seq);
+    e->seq = NULL;
+    e->cached = FALSE;
+    c->memory -= e->memory;
+    e->memory = 0;
+    c->cached[i] = c->cached[--c->ncached];
+    ++c->evicted;
+}
+
+/**
+ * \brief Called for every node built on the way to the requested node.
+ */
+void mutation_cache_visit(mutation_cache *c, tnode *node, unsigned int depth, const char *seq)
+{
+    mutation_cache_entry *e = NULL;
+    if (c->policy == CacheStride)
+    {
+        if (depth % c->stride != 0)
+        {
+            return;
+        }
+    }
+    else
+    {
+        e = mutation_cache_entry_get(c, node, depth);
+        if (++e->count < 2)
+        {
+            return;
+        }
+    }
+
+    /* Exact cost, runs of ambiguous residues included. */
+    const size_t length = strlen(seq);
+    size_t memory = length + 1;
+    cseq packed;
+    int pack = c->packed;
+    size_t i = 0;
+    for (; pack && i < length; ++i)
+    {
+        const unsigned char r = (unsigned char)seq[i];
+        if (islower(r) && cseq_code[r] != 4)
+        {
+            pack = FALSE; /* Soft-masked nucleotides would come back uppercase. */
+        }
+    }
+    if (pack)
+    {
+        cseq_pack(&packed, seq, (unsigned int)length);
+        memory = sizeof(uint64_t) * (packed.capacity / CSEQ_WORD + 1) + packed.amb_capacity * sizeof(cseq_run);
+    }
+
+    int admit = (c->budget == 0 || c->memory + memory <= c->budget);
+    if (!admit && c->policy == CacheFrequency && memory <= c->budget)
+    {
+        admit = TRUE;
+        while (c->memory + memory > c->budget)
+        {
+            /* Least used cached node, only replaced if it is used less. */
+            size_t imin = 0;
+            uint64_t min = UINT64_MAX;
+            for (i = 0; i < c->ncached; ++i)
+            {
+                const uint64_t count = mutation_cache_find(c, c->cached[i])->count;
+                if (count < min)
+                {
+                    min = count;
+                    imin = i;
+                }
+            }
+            if (min >= e->count)
+            {
+                admit = FALSE;
+                break;
+            }
+            mutation_cache_evict(c, imin);
+        }
+    }
+    if (!admit)
+    {
+        if (pack)
+        {
+            cseq_free(&packed);
+        }
+        return;
+    }
+    if (e == NULL)
+    {
+        e = mutation_cache_entry_get(c, node, depth);
+    }
+    mutation_cache_store(c, e, seq, length, pack ? &packed : NULL, memory);
+}
+
+/**
+ * \brief Build the complete sequence for a node of the tree, using the cache.
+ *
+ * \param c       The cache.
+ * \param node    Node of the mutation tree.
+ * \return        Sequence (to free with free).
+ */
+char *mutation_cache_get(mutation_cache *c, tnode *node)
+{
+    size_t n = 0;
+    size_t capacity = 64;
+    tnode **path = (tnode**)malloc(capacity * sizeof(tnode*));
+    mutation_cache_entry *e = NULL;
+    tnode *t = node;
+    for (; t != NULL; t = t->p)
+    {
+        e = mutation_cache_find(c, t);
+        if (e != NULL && e->cached)
+        {
+            break;
+        }
+        if (n == capacity)
+        {
+            capacity *= 2;
+            path = (tnode**)realloc(path, capacity * sizeof(tnode*));
+        }
+        path[n++] = t;
+    }
+
+    char *seq;
+    unsigned int depth;
+    if (t != NULL)
+    {
+        ++c->hits;
+        ++e->count;
+        depth = e->depth;
+        if (e->seq == NULL)
+        {
+            seq = cseq_to_string(&e->packed);
+        }
+        else
+        {
+            const size_t length = strlen(e->seq);
+            seq = (char*)malloc(length + 1);
+            memcpy(seq, e->seq, length + 1);
+        }
+    }
+    else
+    {
+        ++c->misses;
+        const size_t length = strlen(c->mt->seq);
+        seq = (char*)malloc(length + 1);
+        memcpy(seq, c->mt->seq, length + 1);
+        depth = (unsigned int)-1; /* The root is at depth 0. */
+    }
+
+    while (n > 0)
+    {
+        tnode *p = path[--n];
+        ++depth;
+        c->applied += apply_node_mutations(&seq, p);
+        if (depth > 0)
+        {
+            mutation_cache_visit(c, p, depth, seq);
+        }
+    }
+    free(path);
+    return seq;
+}
+
+/**
+ * \brief Called for every leaf by mutation_tree_leaves.
+ *
+ * The sequence is only valid during the call.
+ */
+typedef void (*leaf_callback)(const tnode *leaf, const char *seq, size_t length, void *data);
+
+/**
+ * \brief How to revert a mutation applied on the working rope.
+ */
+typedef struct
+{
+    mut_type type; /**< Type of the mutation. */
+
+    unsigned int pos; /**< Position of the mutation. */
+
+    unsigned int t; /**< Pieces removed by the mutation (Point, Deletions). */
+
+    unsigned int length; /**< Number of residues inserted (Insertions). */
+}
+mutation_undo;
+
+/**
+ * \brief Build the sequences of all the leaves in a single depth-first walk.
+ *
+ * A single working rope follows the walk: the mutations of a node are applied
+ * on the way down, and reverted on the way up from an undo log (the removed
+ * pieces are kept, not copied). Each edit costs O(log p) for p pieces whatever
+ * the length of the sequence, and each leaf is flattened once into the same
+ * buffer, so the total cost is O(m log p + leaves x length) for m mutations.
+ * Inserts are not copied: the mutation tree must not change during the walk.
+ *
+ * \param mt      The mutation tree.
+ * \param cb      Called for every leaf (in depth-first order).
+ * \param data    Passed to the callback.
+ * \return        Number of leaves.
+ */
+uint64_t mutation_tree_leaves(const mutation_tree *mt, leaf_callback cb, void *data)
+{
+    typedef struct
+    {
+        tnode *node;
+        sllnode *child; /* Next child to visit. */
+        size_t mark; /* Size of the undo log before the node. */
+    }
+    frame;
+
+    uint64_t nleaves = 0;
+    size_t capacity = 64;
+    size_t top = 0;
+    frame *stack = (frame*)malloc(capacity * sizeof(frame));
+    size_t nundo = 0;
+    size_t undo_capacity = 64;
+    mutation_undo *undo = (mutation_undo*)malloc(undo_capacity * sizeof(mutation_undo));
+    size_t buffer_capacity = strlen(mt->seq) + 1;
+    char *buffer = (char*)malloc(buffer_capacity);
+    rope r;
+    rope_init(&r, mt->seq, buffer_capacity - 1);
+
+    tnode *node = mt->root;
+    while (node != NULL || top > 0)
+    {
+        if (node != NULL)
+        {
+            /* Down: apply the mutations of the node and log how to revert them. */
+            const size_t mark = nundo;
+            sllnode *l = (node->data != NULL) ? ((sll*)node->data)->head : NULL;
+            for (; l != NULL; l = l->next)
+            {
+                mutation *m = (mutation*)l->data;
+                if (nundo == undo_capacity)
+                {
+                    undo_capacity *= 2;
+                    undo = (mutation_undo*)realloc(undo, undo_capacity * sizeof(mutation_undo));
+                }
+                mutation_undo *u = undo + nundo++;
+                u->type = m->type;
+                u->pos = m->pos;
+                if (m->type == Point)
+                {
+                    u->t = rope_cut(&r, m->pos, 1);
+                    rope_paste(&r, m->pos, rope_piece(&r, &m->mut.newc, 1));
+                }
+                else if (m->type == Insertions)
+                {
+                    u->length = (unsigned int)strlen(m->mut.insert);
+                    if (u->length > 0)
+                    {
+                        rope_paste(&r, m->pos, rope_piece(&r, m->mut.insert, u->length));
+                    }
+                }
+                else
+                {
+                    u->t = rope_cut(&r, m->pos, m->mut.ndels);
+                }
+            }
+
+            if (node->n == 0)
+            {
+                const size_t length = rope_length(&r);
+                if (length + 1 > buffer_capacity)
+                {
+                    buffer_capacity = 2 * (length + 1);
+                    buffer = (char*)realloc(buffer, buffer_capacity);
+                }
+                rope_flatten(&r, buffer);
+                cb(node, buffer, length, data);
+                ++nleaves;
+            }
+
+            if (top == capacity)
+            {
+                capacity *= 2;
+                stack = (frame*)realloc(stack, capacity * sizeof(frame));
+            }
+            stack[top].node = node;
+            stack[top].child = node->children.head;
+            stack[top++].mark = mark;
+            node = NULL;
+        }
+
+        frame *f = stack + top - 1;
+        if (f->child != NULL)
+        {
+            node = (tnode*)f->child->data;
+            f->child = f->child->next;
+            continue;
+        }
+
+        /* Up: revert the mutations of the node, last applied first. */
+        while (nundo > f->mark)
+        {
+            const mutation_undo *u = undo + --nundo;
+            if (u->type == Point)
+            {
+                rope_release(&r, rope_cut(&r, u->pos, 1));
+                rope_paste(&r, u->pos, u->t);
+            }
+            else if (u->type == Insertions)
+            {
+                rope_release(&r, rope_cut(&r, u->pos, u->length));
+            }
+            else
+            {
+                rope_paste(&r, u->pos, u->t);
+            }
+        }
+        --top;
+    }
+
+    rope_free(&r);
+    free(buffer);
+    free(undo);
+    free(stack);
+    return nleaves;
+}
+
 #ifdef __cplusplus
 }
 #endif
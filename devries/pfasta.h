@@ -0,0 +1,312 @@
+/*! \file
+ *
+ * \brief Read whole FASTA files with several threads.
+ *
+ * Requires POSIX threads (compile with -pthread).
+ */ 
+
+#ifndef PFASTA_H_
+#define PFASTA_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "devries.h"
+#include "seq.h"
+
+/* For C++ compilers: */
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * \brief Number of pieces per thread (more pieces balance the work better).
+ */
+#define PFASTA_PIECES 8
+
+/**
+ * \brief A piece of the file parsed by one thread.
+ *
+ * Pieces start and end on line boundaries, so each line (and each header) is in
+ * exactly one piece.
+ */
+typedef struct
+{
+    size_t begin; /**< First byte of the piece. */
+
+    size_t end; /**< One past the last byte of the piece. */
+
+    unsigned int nheaders; /**< Number of headers in the piece. */
+
+    unsigned int *counts; /**< Residues before the first header, then after each header. */
+
+    unsigned int capacity; /**< Capacity of 'counts'. */
+
+    unsigned int record; /**< Record continued at the start of the piece (first header of the piece if none). */
+
+    unsigned int pos; /**< Position in 'record' of the first residue of the piece. */
+}
+pfasta_piece;
+
+/**
+ * \brief Shared state of the threads.
+ */
+typedef struct
+{
+    const seq_map *map; /**< The file. */
+
+    pfasta_piece *pieces; /**< The pieces. */
+
+    unsigned int npieces; /**< Number of pieces. */
+
+    unsigned int next; /**< Next piece to parse. */
+
+    pthread_mutex_t lock; /**< Protects 'next'. */
+
+    int copy; /**< 0 (FALSE) to count the residues, 1 (TRUE) to copy them. */
+
+    sequence *seqs; /**< The sequences, for the copy. */
+}
+pfasta_job;
+
+/**
+ * \brief Count (first pass) or copy (second pass) the residues of a piece.
+ *
+ * \param job    The job.
+ * \param p      The piece.
+ */
+void pfasta_parse(pfasta_job *job, pfasta_piece *p)
+{
+    const char *data = job->map->data;
+    size_t pos = p->begin;
+    unsigned int record = p->record;
+    char *dst = NULL;
+
+    if (job->copy)
+    {
+        dst = (record < UINT_MAX) ? job->seqs[record].seq + p->pos : NULL;
+    }
+    else
+    {
+        p->nheaders = 0;
+        p->counts[0] = 0;
+    }
+
+    while (pos < p->end)
+    {
+        const char *eol = (const char*)memchr(data + pos, '\n', p->end - pos);
+        const size_t next = (eol == NULL) ? p->end : (size_t)(eol - data) + 1;
+        size_t end = (eol == NULL) ? p->end : next - 1;
+
+        if (data[pos] == '>')
+        {
+            if (job->copy)
+            {
+                ++record;
+                sequence *s = &job->seqs[record];
+                if (end > pos && data[end - 1] == '\r')
+                {
+                    --end;
+                }
+                s->seq_info = (char*)malloc(end - pos);
+                memcpy(s->seq_info, data + pos + 1, end - pos - 1);
+                s->seq_info[end - pos - 1] = '\0';
+                dst = s->seq;
+            }
+            else
+            {
+                if (p->nheaders + 1 == p->capacity)
+                {
+                    p->capacity *= 2;
+                    p->counts = (unsigned int*)realloc((void*)p->counts, p->capacity * sizeof(unsigned int));
+                }
+                p->counts[++p->nheaders] = 0;
+            }
+        }
+        else
+        {
+            if (end > pos && data[end - 1] == '\r')
+            {
+                --end;
+            }
+            if (!job->copy)
+            {
+                p->counts[p->nheaders] += (unsigned int)(end - pos);
+            }
+            else if (dst != NULL)
+            {
+                memcpy(dst, data + pos, end - pos);
+                dst += end - pos;
+            }
+        }
+        pos = next;
+    }
+}
+
+/**
+ * \brief Main function of the threads: parse pieces until there is none left.
+ *
+ * \param arg    The job.
+ * \return       NULL.
+ */
+void *pfasta_worker(void *arg)
+{
+    pfasta_job *job = (pfasta_job*)arg;
+    for (;;)
+    {
+        pthread_mutex_lock(&job->lock);
+        const unsigned int i = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (i >= job->npieces)
+        {
+            return NULL;
+        }
+        pfasta_parse(job, &job->pieces[i]);
+    }
+}
+
+/**
+ * \brief Run a pass over all the pieces with nthreads threads.
+ *
+ * \param job        The job.
+ * \param nthreads   Number of threads.
+ */
+void pfasta_run(pfasta_job *job, unsigned int nthreads)
+{
+    pthread_t *threads = (pthread_t*)malloc(nthreads * sizeof(pthread_t));
+    job->next = 0;
+
+    /* Threads that could not be created leave their share to the others. */
+    unsigned int created = 1;
+    for (; created < nthreads; ++created)
+    {
+        if (pthread_create(&threads[created], NULL, pfasta_worker, (void*)job) != 0)
+        {
+            break;
+        }
+    }
+    pfasta_worker((void*)job);
+    unsigned int i = 1;
+    for (; i < created; ++i)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+}
+
+/**
+ * \brief Read all the sequences of a FASTA file with several threads.
+ *
+ * The mapped file is cut in pieces on line boundaries, so a file with a few huge
+ * records is split as well as a file with many small records. A first parallel
+ * pass counts the residues of each piece, the sequences are allocated to their
+ * exact size and a second parallel pass copies the residues in place.
+ *
+ * The sequences must be freed with sequence_free and the array with free.
+ * 
+ * \param filename   Name of the input file.
+ * \param nthreads   Number of threads (0 for the number of processors).
+ * \param nseqs      Set to the number of sequences.
+ * \return           An array of sequences (NULL if the file could not be read).
+ */
+sequence *read_fasta_parallel(const char *filename, unsigned int nthreads, unsigned int *nseqs)
+{
+    seq_map map;
+    pfasta_job job;
+
+    *nseqs = 0;
+    if (!seq_map_open(&map, filename))
+    {
+        return NULL;
+    }
+    if (nthreads == 0)
+    {
+        const long nprocs = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (nprocs > 0) ? (unsigned int)nprocs : 1;
+    }
+
+    /* Cut the file in pieces ending on a newline. */
+    job.map = &map;
+    job.npieces = nthreads * PFASTA_PIECES;
+    job.pieces = (pfasta_piece*)malloc(job.npieces * sizeof(pfasta_piece));
+    pthread_mutex_init(&job.lock, NULL);
+    size_t begin = 0;
+    unsigned int i = 0;
+    for (; i < job.npieces; ++i)
+    {
+        size_t end = (i + 1 == job.npieces) ? map.size : (size_t)((double)map.size * (i + 1) / job.npieces);
+        if (end < begin)
+        {
+            end = begin;
+        }
+        if (end > 0 && end < map.size && map.data[end - 1] != '\n')
+        {
+            const char *eol = (const char*)memchr(map.data + end, '\n', map.size - end);
+            end = (eol == NULL) ? map.size : (size_t)(eol - map.data) + 1;
+        }
+        pfasta_piece *p = &job.pieces[i];
+        p->begin = begin;
+        p->end = end;
+        p->capacity = 16;
+        p->counts = (unsigned int*)malloc(p->capacity * sizeof(unsigned int));
+        begin = end;
+    }
+
+    job.copy = FALSE;
+    pfasta_run(&job, nthreads);
+
+    /* Sizes of the records and where each piece starts writing. */
+    unsigned int n = 0;
+    for (i = 0; i < job.npieces; ++i)
+    {
+        n += job.pieces[i].nheaders;
+    }
+    sequence *seqs = (sequence*)malloc((n > 0 ? n : 1) * sizeof(sequence));
+    unsigned int record = UINT_MAX; /* No record before the first header. */
+    for (i = 0; i < job.npieces; ++i)
+    {
+        pfasta_piece *p = &job.pieces[i];
+        p->record = record;
+        p->pos = (record == UINT_MAX) ? 0 : seqs[record].length;
+        if (record != UINT_MAX)
+        {
+            seqs[record].length += p->counts[0];
+        }
+        unsigned int j = 1;
+        for (; j <= p->nheaders; ++j)
+        {
+            ++record;
+            seqs[record].length = p->counts[j];
+        }
+    }
+    for (i = 0; i < n; ++i)
+    {
+        seqs[i].seq = (char*)malloc(seqs[i].length + 1);
+        seqs[i].seq[seqs[i].length] = '\0';
+    }
+
+    job.copy = TRUE;
+    job.seqs = seqs;
+    pfasta_run(&job, nthreads);
+
+    for (i = 0; i < job.npieces; ++i)
+    {
+        free(job.pieces[i].counts);
+    }
+    free(job.pieces);
+    pthread_mutex_destroy(&job.lock);
+    seq_map_close(&map);
+    *nseqs = n;
+    return seqs;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
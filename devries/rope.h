@@ -0,0 +1,495 @@
+/*! \file
+ *
+ * \brief An editable sequence (piece table) with logarithmic inserts and deletions.
+ *
+ * The sequence is a list of pieces, each one pointing into the original
+ * sequence or into an append-only buffer of inserted residues. The pieces are
+ * the nodes of an implicit treap (a binary search tree on the positions,
+ * balanced by random priorities), so inserting or deleting anywhere costs
+ * O(log p) for p pieces instead of moving the tail of the sequence. Applying
+ * k indels to a sequence of length n and flattening it costs O(k log k + n).
+ */
+
+#ifndef ROPE_H_
+#define ROPE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include "devries.h"
+
+/* For C++ compilers: */
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Minimum size of the blocks of inserted residues. */
+#define ROPE_BLOCK 65536
+
+/**
+ * \brief A piece of the sequence and a node of the treap.
+ */
+typedef struct
+{
+    const char *s; /**< First residue of the piece. */
+
+    uint64_t size; /**< Number of residues in the subtree. */
+
+    unsigned int length; /**< Number of residues in the piece. */
+
+    unsigned int priority; /**< Priority (larger than the ones of the children). */
+
+    unsigned int left; /**< Left child (0 for none). */
+
+    unsigned int right; /**< Right child (0 for none). */
+}
+rope_node;
+
+/**
+ * \brief A block of inserted residues (never moves once allocated).
+ */
+typedef struct
+{
+    char *data; /**< The residues. */
+
+    size_t used; /**< Number of residues in the block. */
+
+    size_t capacity; /**< Capacity of the block. */
+}
+rope_block;
+
+/**
+ * \brief An editable sequence.
+ */
+typedef struct
+{
+    rope_node *nodes; /**< Pool of nodes, the node 0 is the empty tree. */
+
+    unsigned int nnodes; /**< Number of nodes used in the pool. */
+
+    unsigned int capacity; /**< Capacity of the pool. */
+
+    unsigned int free_nodes; /**< Chain of released nodes (through 'left'). */
+
+    unsigned int root; /**< Root of the treap. */
+
+    rope_block *blocks; /**< Blocks of inserted residues. */
+
+    unsigned int nblocks; /**< Number of blocks. */
+
+    unsigned int blocks_capacity; /**< Capacity of the array of blocks. */
+
+    uint32_t seed; /**< State of the generator of priorities. */
+}
+rope;
+
+/**
+ * \brief Next priority (xorshift32).
+ */
+unsigned int rope_priority(rope *r)
+{
+    r->seed ^= r->seed << 13;
+    r->seed ^= r->seed >> 17;
+    r->seed ^= r->seed << 5;
+    return r->seed;
+}
+
+/**
+ * \brief New node for a piece (may move the pool).
+ */
+unsigned int rope_node_new(rope *r, const char *s, unsigned int length, unsigned int priority)
+{
+    unsigned int i = r->free_nodes;
+    if (i != 0)
+    {
+        r->free_nodes = r->nodes[i].left;
+    }
+    else
+    {
+        if (r->nnodes == r->capacity)
+        {
+            r->capacity *= 2;
+            r->nodes = (rope_node*)realloc(r->nodes, r->capacity * sizeof(rope_node));
+        }
+        i = r->nnodes++;
+    }
+    r->nodes[i].s = s;
+    r->nodes[i].size = length;
+    r->nodes[i].length = length;
+    r->nodes[i].priority = priority;
+    r->nodes[i].left = 0;
+    r->nodes[i].right = 0;
+    return i;
+}
+
+/**
+ * \brief Update the size of a node from its children.
+ */
+void rope_update(rope *r, unsigned int i)
+{
+    rope_node *n = r->nodes + i;
+    n->size = n->length + r->nodes[n->left].size + r->nodes[n->right].size;
+}
+
+/**
+ * \brief Free the memory of a rope (not the initial sequence).
+ *
+ * \param r    The rope.
+ */
+void rope_free(rope *r)
+{
+    unsigned int i = 0;
+    for (; i < r->nblocks; ++i)
+    {
+        free(r->blocks[i].data);
+    }
+    free(r->blocks);
+    free(r->nodes);
+    r->blocks = NULL;
+    r->nodes = NULL;
+    r->nblocks = 0;
+    r->root = 0;
+}
+
+/**
+ * \brief Length of the sequence.
+ *
+ * \param r    The rope.
+ * \return     Number of residues.
+ */
+uint64_t rope_length(const rope *r)
+{
+    return r->nodes[r->root].size;
+}
+
+/**
+ * \brief Copy residues in the append-only buffer.
+ *
+ * \return     A pointer to the copy (valid until rope_free).
+ */
+const char *rope_store(rope *r, const char *s, size_t length)
+{
+    rope_block *b = (r->nblocks > 0) ? r->blocks + r->nblocks - 1 : NULL;
+    if (b == NULL || b->capacity - b->used < length)
+    {
+        if (r->nblocks == r->blocks_capacity)
+        {
+            r->blocks_capacity = (r->blocks_capacity == 0) ? 16 : 2 * r->blocks_capacity;
+            r->blocks = (rope_block*)realloc(r->blocks, r->blocks_capacity * sizeof(rope_block));
+        }
+        b = r->blocks + r->nblocks++;
+        b->capacity = (length > ROPE_BLOCK) ? length : ROPE_BLOCK;
+        b->data = (char*)malloc(b->capacity);
+        b->used = 0;
+    }
+    char *dst = b->data + b->used;
+    memcpy(dst, s, length);
+    b->used += length;
+    return dst;
+}
+
+/**
+ * \brief Concatenate two treaps.
+ */
+unsigned int rope_merge(rope *r, unsigned int a, unsigned int b)
+{
+    if (a == 0 || b == 0)
+    {
+        return a + b;
+    }
+    if (r->nodes[a].priority > r->nodes[b].priority)
+    {
+        r->nodes[a].right = rope_merge(r, r->nodes[a].right, b);
+        rope_update(r, a);
+        return a;
+    }
+    r->nodes[b].left = rope_merge(r, a, r->nodes[b].left);
+    rope_update(r, b);
+    return b;
+}
+
+/**
+ * \brief Split a treap: the first 'pos' residues go left, the others right.
+ *
+ * A piece straddling the position is cut in two.
+ */
+void rope_split(rope *r, unsigned int t, uint64_t pos, unsigned int *left, unsigned int *right)
+{
+    if (t == 0)
+    {
+        *left = 0;
+        *right = 0;
+        return;
+    }
+    const uint64_t lsize = r->nodes[r->nodes[t].left].size;
+    const unsigned int length = r->nodes[t].length;
+    unsigned int a, b;
+    if (pos <= lsize)
+    {
+        rope_split(r, r->nodes[t].left, pos, &a, &b);
+        r->nodes[t].left = b;
+        rope_update(r, t);
+        *left = a;
+        *right = t;
+    }
+    else if (pos >= lsize + length)
+    {
+        rope_split(r, r->nodes[t].right, pos - lsize - length, &a, &b);
+        r->nodes[t].right = a;
+        rope_update(r, t);
+        *left = t;
+        *right = b;
+    }
+    else
+    {
+        /* The tail of the piece gets a new priority and is merged with the
+           right subtree: with the priority of 't', the tails left by repeated
+           cuts would all tie and the treap would degenerate into a chain. */
+        const unsigned int k = (unsigned int)(pos - lsize);
+        const unsigned int n = rope_node_new(r, r->nodes[t].s + k, length - k, rope_priority(r));
+        const unsigned int tail = r->nodes[t].right;
+        r->nodes[t].length = k;
+        r->nodes[t].right = 0;
+        rope_update(r, t);
+        *left = t;
+        *right = rope_merge(r, n, tail);
+    }
+}
+
+/**
+ * \brief Initialize a rope.
+ *
+ * The sequence is not copied: it has to outlive the rope.
+ *
+ * \param r        A pointer to an unitialized 'rope' object.
+ * \param seq      The initial sequence.
+ * \param length   Length of the sequence.
+ */
+void rope_init(rope *r, const char *seq, size_t length)
+{
+    r->capacity = 64;
+    r->nodes = (rope_node*)malloc(r->capacity * sizeof(rope_node));
+    memset(r->nodes, 0, sizeof(rope_node));
+    r->nnodes = 1;
+    r->free_nodes = 0;
+    r->root = 0;
+    r->blocks = NULL;
+    r->nblocks = 0;
+    r->blocks_capacity = 0;
+    r->seed = 2463534242u;
+    /* Pieces hold at most UINT_MAX residues. */
+    while (length > 0)
+    {
+        const unsigned int n = (length > UINT_MAX) ? UINT_MAX : (unsigned int)length;
+        r->root = rope_merge(r, r->root, rope_node_new(r, seq, n, rope_priority(r)));
+        seq += n;
+        length -= n;
+    }
+}
+
+/**
+ * \brief Release the nodes of a subtree.
+ */
+void rope_release(rope *r, unsigned int t)
+{
+    while (t != 0)
+    {
+        /* Rotate the left child up until there is none, then drop the node. */
+        rope_node *n = r->nodes + t;
+        if (n->left != 0)
+        {
+            const unsigned int l = n->left;
+            n->left = r->nodes[l].right;
+            r->nodes[l].right = t;
+            t = l;
+        }
+        else
+        {
+            const unsigned int next = n->right;
+            n->left = r->free_nodes;
+            r->free_nodes = t;
+            t = next;
+        }
+    }
+}
+
+/**
+ * \brief Detached tree of a single piece, not copied (see rope_paste).
+ *
+ * \param r        The rope.
+ * \param s        The residues (have to outlive the rope).
+ * \param length   Number of residues.
+ * \return         The piece.
+ */
+unsigned int rope_piece(rope *r, const char *s, unsigned int length)
+{
+    return rope_node_new(r, s, length, rope_priority(r));
+}
+
+/**
+ * \brief Detach a range of residues, O(log p).
+ *
+ * The pieces are kept as a tree that can be pasted back (rope_paste) or
+ * released (rope_release).
+ *
+ * \param r        The rope.
+ * \param pos      First residue to detach.
+ * \param length   Number of residues (clipped at the end).
+ * \return         The detached tree (0 if empty).
+ */
+unsigned int rope_cut(rope *r, uint64_t pos, uint64_t length)
+{
+    assert(pos <= rope_length(r));
+    unsigned int a, b, c, d;
+    rope_split(r, r->root, pos, &a, &b);
+    rope_split(r, b, length, &c, &d);
+    r->root = rope_merge(r, a, d);
+    return c;
+}
+
+/**
+ * \brief Insert a detached tree, O(log p).
+ *
+ * \param r       The rope.
+ * \param pos     Where to insert (0 to rope_length).
+ * \param t       The tree (from rope_cut or rope_piece).
+ */
+void rope_paste(rope *r, uint64_t pos, unsigned int t)
+{
+    assert(pos <= rope_length(r));
+    unsigned int a, b;
+    rope_split(r, r->root, pos, &a, &b);
+    r->root = rope_merge(r, rope_merge(r, a, t), b);
+}
+
+/**
+ * \brief Insert residues, O(log p).
+ *
+ * \param r        The rope.
+ * \param pos      Where to insert (0 to rope_length).
+ * \param s        The residues (copied).
+ * \param length   Number of residues.
+ */
+void rope_insert(rope *r, uint64_t pos, const char *s, size_t length)
+{
+    assert(pos <= rope_length(r));
+    assert(length <= UINT_MAX);
+    if (length == 0)
+    {
+        return;
+    }
+    rope_paste(r, pos, rope_piece(r, rope_store(r, s, length), (unsigned int)length));
+}
+
+/**
+ * \brief Delete residues, O(log p).
+ *
+ * \param r        The rope.
+ * \param pos      First residue to delete.
+ * \param length   Number of residues to delete (clipped at the end).
+ */
+void rope_delete(rope *r, uint64_t pos, uint64_t length)
+{
+    rope_release(r, rope_cut(r, pos, length));
+}
+
+/**
+ * \brief Residue at a position, O(log p).
+ *
+ * \param r      The rope.
+ * \param pos    The position.
+ * \return       The residue.
+ */
+char rope_get(const rope *r, uint64_t pos)
+{
+    assert(pos < rope_length(r));
+    unsigned int t = r->root;
+    for (;;)
+    {
+        const rope_node *n = r->nodes + t;
+        const uint64_t lsize = r->nodes[n->left].size;
+        if (pos < lsize)
+        {
+            t = n->left;
+        }
+        else if (pos < lsize + n->length)
+        {
+            return n->s[pos - lsize];
+        }
+        else
+        {
+            pos -= lsize + n->length;
+            t = n->right;
+        }
+    }
+}
+
+/**
+ * \brief Replace a residue, O(log p).
+ *
+ * \param r      The rope.
+ * \param pos    The position.
+ * \param c      The new residue.
+ */
+void rope_set(rope *r, uint64_t pos, char c)
+{
+    rope_delete(r, pos, 1);
+    rope_insert(r, pos, &c, 1);
+}
+
+/**
+ * \brief Write the sequence in a buffer, O(n).
+ *
+ * \param r      The rope.
+ * \param dst    Where to write the rope_length + 1 residues (NUL-terminated).
+ */
+void rope_flatten(const rope *r, char *dst)
+{
+    /* In-order walk with an explicit stack (expected depth O(log p)). */
+    unsigned int stack_capacity = 64;
+    unsigned int top = 0;
+    unsigned int *stack = (unsigned int*)malloc(stack_capacity * sizeof(unsigned int));
+    unsigned int t = r->root;
+    while (t != 0 || top > 0)
+    {
+        while (t != 0)
+        {
+            if (top == stack_capacity)
+            {
+                stack_capacity *= 2;
+                stack = (unsigned int*)realloc(stack, stack_capacity * sizeof(unsigned int));
+            }
+            stack[top++] = t;
+            t = r->nodes[t].left;
+        }
+        t = stack[--top];
+        memcpy(dst, r->nodes[t].s, r->nodes[t].length);
+        dst += r->nodes[t].length;
+        t = r->nodes[t].right;
+    }
+    *dst = '\0';
+    free(stack);
+}
+
+/**
+ * \brief Return the sequence as a string.
+ *
+ * \param r    The rope.
+ * \return     The sequence (NUL-terminated, to free with free).
+ */
+char *rope_to_string(const rope *r)
+{
+    char *str = (char*)malloc(rope_length(r) + 1);
+    rope_flatten(r, str);
+    return str;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -11,8 +11,20 @@
 #include <assert.h>
 #include <stdint.h>
 #include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 #include <libxml/parser.h>
+#include <libxml/xmlreader.h>
 #include "devries.h"
+#include "bgzf.h"
+#include "cseq.h"
+#include "gcode.h"
 #include "well1024.h"
 
 /* For C++ compilers: */
@@ -45,1013 +57,3255 @@ typedef struct
 sequence;
 
 /**
- * \brief A compressed sequence represented by a bitfield.
+ * \brief Free the memory used by a sequence object.
+ *
+ * \param seq    The sequence to free.
+ */
+void sequence_free(sequence *seq)
+{
+    free(seq->seq);
+    free(seq->seq_info);
+    seq->seq = NULL;
+    seq->seq_info = NULL;
+    seq->length = 0;
+}
+
+/**
+ * \brief A read-only view of a whole file.
+ *
+ * Uncompressed files are mapped in memory with mmap so only the pages actually
+ * used are read from the disk. Compressed files (gzip or BGZF) are decompressed
+ * in memory.
  */
 typedef struct
 {
-    char *seq; /**< The sequence. */
+    char *data; /**< Content of the file (NULL if the file is empty). */
 
-    unsigned int length; /**< Length of the sequence. */
+    size_t size; /**< Size of the content in bytes. */
 
-    unsigned int capacity; /**< Capacity of the object. */
+    int owned; /**< 1 (TRUE) if 'data' was decompressed in memory, 0 (FALSE) if it is mapped. */
 }
-cseq;
+seq_map;
 
 /**
- * \brief Extract the nth sequence from a file in fasta format.
+ * \brief Map a file in memory, decompressing it if necessary.
  *
- * Extract a sequence and store it in a sequence object.
- * 
- * \param filename   Name of the input file.
- * \param n          Index of the sequence.
- * \param fasta      A pointer to an unitialized 'sequence' object.
+ * \param m          A pointer to an unitialized 'seq_map' object.
+ * \param filename   Name of the file to map.
+ * \return           1 (TRUE) if the file has been mapped.
  */
-void read_fasta(const char *filename, unsigned int n, sequence *seq)
+int seq_map_open(seq_map *m, const char *filename)
 {
-    /*
-    FILE* input = fopen(filename, "r");
-
-    fseek(input, 0, SEEK_END);
-    const long file_size = ftell(input);
-    fseek(input, 0, SEEK_SET);
+    bgzf_file bf;
 
-    char *complete_file = (char*)malloc(file_size);
-    size_t fread_size = fread((void*)complete_file, sizeof(char), file_size, input);
-    const unsigned int complete_file_size = strlen(complete_file);
-
-    unsigned int i = 0;
-    while (i < complete_file_size)
+    m->data = NULL;
+    m->size = 0;
+    m->owned = FALSE;
+    if (!bgzf_open(&bf, filename, 0))
     {
-        if (complete_file[i] == '>')
-        {
-            const int i0 = i;
-            while (complete_file[i] != '\n')
-            {
-                ++i;
-            }
-            fasta->seq_info = (char*)malloc(i - i0 + 1);
-            strncpy(fasta->seq_info, complete_file + i0, i - i0);
-
-            fasta->seq = (char*)malloc(complete_file_size);
-            int j = 0;
-
-            while (i < complete_file_size)
-            {
-                if (complete_file[i] != '\n' && complete_file[i] != '\r')
-                {
-                    fasta->seq[j++] = complete_file[i];
-                }
-                ++i;
-            }
-            fasta->seq[j] = '\0';
-            fasta->length = strlen(fasta->seq);
-            break;
-        }
+        return FALSE;
+    }
+    if (bf.format == Plain)
+    {
+        /* Keep the mapping made by bgzf_open. */
+        m->data = (char*)bf.cdata;
+        m->size = bf.csize;
+        return TRUE;
     }
-    fasta->type = get_type(fasta->seq);
-    fclose(fp);
-    */
+    m->data = bgzf_read_all(&bf, &m->size);
+    m->owned = TRUE;
+    bgzf_close(&bf);
+    return m->data != NULL;
 }
 
 /**
- * \brief Extract the nth sequence from a file in sequenceml format.
+ * \brief Unmap a file mapped with seq_map_open.
  *
- * Extract a sequence and store it in a sequence object.
- * 
- * \param filename   Name of the input file.
- * \param n          Index of the sequence.
- * \param fasta      A pointer to an unitialized 'sequence' object.
+ * \param m    The mapped file.
  */
-void read_sequenceml(const char *filename, unsigned int n, sequence *seq)
+void seq_map_close(seq_map *m)
 {
-    /*
-    xmlDoc *document;
-    xmlNode *root, *first_child, *node;
-    char *filename;
-
-    if (argc < 2)
+    if (m->owned)
     {
-        fprintf(stderr, "Usage: %s filename.xml\n", argv[0]);
-        return EXIT_FAILURE;
+        free(m->data);
     }
-    filename = argv[1];
-
-    document = xmlReadFile(filename, NULL, 0);
-    root = xmlDocGetRootElement(document);
-    fprintf(stdout, "Root is <%s> (%i)\n", root->name, root->type);
-    first_child = root->children;
-
-    for (node = first_child; node; node = node->next)
+    else if (m->data != NULL)
     {
-        fprintf(stdout, "\t Child is <%s> (%i)\n", node->name, node->type);
+        munmap((void*)m->data, m->size);
     }
-    fprintf(stdout, "...\n");
-    */
+    m->data = NULL;
+    m->size = 0;
 }
 
 /**
- * \brief Extract the nth sequence from a file in EMBL format.
+ * \brief A record of a FASTA index.
  *
- * Extract a sequence and store it in a sequence object.
- * 
- * \param filename   Name of the input file.
- * \param n          Index of the sequence.
- * \param fasta      A pointer to an unitialized 'sequence' object.
+ * Same fields as a line of the .fai files used by samtools, so the index files
+ * can be shared with other tools.
  */
-void read_embl(const char *filename, unsigned int n, sequence *seq);
+typedef struct
+{
+    char *name; /**< Name of the sequence (first word of the header). */
+
+    unsigned int length; /**< Number of residues. */
+
+    uint64_t offset; /**< Offset of the first residue in the file. */
+
+    unsigned int line_bases; /**< Number of residues on the first line. */
+
+    unsigned int line_width; /**< Number of bytes on the first line (with the end of line). */
+}
+fasta_record;
 
 /**
- * \brief Extract the nth sequence from a file in genbank format.
- *
- * Extract a sequence and store it in a sequence object.
- * 
- * \param filename   Name of the input file.
- * \param n          Index of the sequence.
- * \param fasta      A pointer to an unitialized 'sequence' object.
+ * \brief An index of the records in a FASTA file.
  */
-void read_genbank(const char *filename, unsigned int n, sequence *seq);
+typedef struct
+{
+    fasta_record *records; /**< The records, in the order of the file. */
+
+    unsigned int n; /**< Number of records. */
+
+    unsigned int capacity; /**< Capacity of the array of records. */
+}
+fasta_index;
 
 /**
- * \brief Return a random DNA nucleotide.
- * 
- * \param rng    A random number generator. 
- * \return       'A', 'T', 'C', or 'G'.
+ * \brief A FASTA file opened for random access.
  */
-char dna_random_nuc(well1024 *rng)
+typedef struct
 {
-    return "ATGC"[(int)(well1024_next_double(rng) * 4)];
+    seq_map map; /**< The mapped file (unused for BGZF files). */
+
+    bgzf_file bgzf; /**< The compressed file (BGZF files only). */
+
+    fasta_index index; /**< Offsets of the records. */
 }
+fasta_file;
 
 /**
- * \brief Return a random DNA nucleotide with custom probablity.
+ * \brief Add a record at the end of an index.
  *
- * Return a random nucleotide with given probabilities (with the probability for
- * C = 1 - prob(A + T + G)).
- * 
- * \param rng      A random number generator.
- * \param prob_a   Probability of 'A'.
- * \param prob_t   Probability of 'T'.
- * \param prob_g   Probability of 'G'.
- * \return         'A', 'T', 'C', or 'G'.
+ * \param index    The index.
+ * \param name     Name of the record (will be copied).
+ * \param nlength  Length of the name.
+ * \return         A pointer to the new record.
  */
-char dna_random_nuc_prob(well1024 *rng, double prob_a, double prob_t, double prob_g)
+fasta_record *fasta_index_add(fasta_index *index, const char *name, size_t nlength)
 {
-    const double r = well1024_next_double(rng);
-    if (r < prob_a)
-    {
-        return 'A';
-    }
-    else if (r < prob_a + prob_t)
-    {
-        return 'T';
-    }
-    else if (r < prob_a + prob_t + prob_g)
-    {
-        return 'G';
-    }
-    else
+    if (index->n == index->capacity)
     {
-        return 'C';
+        index->capacity = (index->capacity == 0) ? 64 : 2 * index->capacity;
+        index->records = (fasta_record*)realloc((void*)index->records, index->capacity * sizeof(fasta_record));
     }
+    fasta_record *r = &index->records[index->n++];
+    r->name = (char*)malloc(nlength + 1);
+    memcpy(r->name, name, nlength);
+    r->name[nlength] = '\0';
+    r->length = 0;
+    r->offset = 0;
+    r->line_bases = 0;
+    r->line_width = 0;
+    return r;
 }
 
 /**
- * \brief Return a random DNA sequence.
- * 
- * \param rng        A random number generator.
- * \param seq_size   The length of the resulting sequence.
- * \return           A sequence of 'A', 'T', 'C', or 'G'.
+ * \brief Free the memory of an index.
+ *
+ * \param index    The index to free.
  */
-char *dna_random_nuc_seq(well1024 *rng, unsigned int seq_size)
+void fasta_index_free(fasta_index *index)
 {
-    assert(seq_size > 0);
-    char *dna_seq = (char*)malloc(seq_size + 1);
-    char nuc[4 + 1] = "ATGC";
-
     unsigned int i = 0;
-    for (; i < seq_size; ++i)
+    for (; i < index->n; ++i)
     {
-        dna_seq[i] = nuc[(int)(well1024_next_double(rng) * 4)];
+        free(index->records[i].name);
     }
-    dna_seq[seq_size] = '\0';
-    return dna_seq;
+    free(index->records);
+    index->records = NULL;
+    index->n = 0;
+    index->capacity = 0;
 }
 
 /**
- * \brief Return a random RNA nucleotide.
- * 
- * \param rng    A random number generator. 
- * \return       'A', 'U', 'C', or 'G'.
+ * \brief Builds a FASTA index from data received piece by piece.
+ *
+ * The data doesn't have to be cut on line boundaries, so a file can be indexed
+ * while it is decompressed without keeping it in memory.
  */
-char rna_random_nuc(well1024 *rng)
+typedef struct
 {
-    return "AUGC"[(int)(well1024_next_double(rng) * 4)];
+    fasta_index *index; /**< The index being built. */
+
+    uint64_t line_start; /**< Offset of the current line. */
+
+    int header; /**< 1 (TRUE) if the current line is a header. */
+
+    int naming; /**< 1 (TRUE) while reading the name in a header. */
+
+    int cr; /**< 1 (TRUE) if the last byte seen on the current line is '\r'. */
+
+    char *name; /**< Name read so far. */
+
+    size_t name_length; /**< Length of the name. */
+
+    size_t name_capacity; /**< Capacity of 'name'. */
 }
+fasta_indexer;
 
 /**
- * \brief Return a random RNA nucleotide with custom probablity.
- *
- * Return a random nucleotide with given probabilities (with the probability for
- * C = 1 - prob(A + U + G)).
+ * \brief Initialize an indexer.
  *
- * \param rng      A random number generator.
- * \param prob_a   Probability of 'A'.
- * \param prob_t   Probability of 'U'.
- * \param prob_g   Probability of 'G'.
- * \return         'A', 'U', 'C', or 'G'.
+ * \param fi       A pointer to an unitialized 'fasta_indexer' object.
+ * \param index    A pointer to an unitialized 'fasta_index' object.
  */
-char rna_random_nuc_prob(well1024 *rng, double prob_a, double prob_u, double prob_g)
+void fasta_indexer_init(fasta_indexer *fi, fasta_index *index)
 {
-    const double r = well1024_next_double(rng);
-    if (r < prob_a)
-    {
-        return 'A';
-    }
-    else if (r < prob_a + prob_u)
-    {
-        return 'U';
-    }
-    else if (r < prob_a + prob_u + prob_g)
-    {
-        return 'G';
-    }
-    else
-    {
-        return 'C';
-    }
+    index->records = NULL;
+    index->n = 0;
+    index->capacity = 0;
+    fi->index = index;
+    fi->line_start = 0;
+    fi->header = FALSE;
+    fi->naming = FALSE;
+    fi->cr = FALSE;
+    fi->name_capacity = 64;
+    fi->name_length = 0;
+    fi->name = (char*)malloc(fi->name_capacity);
 }
 
 /**
- * \brief Return a random RNA sequence.
- * 
- * \param rng        A random number generator.
- * \param seq_size   The length of the resulting sequence.
- * \return           A sequence of 'A', 'U', 'C', or 'G'.
+ * \brief Account for a complete line.
+ *
+ * \param fi      The indexer.
+ * \param end     Offset of the end of the line.
+ * \param next    Offset of the next line.
  */
-char* rna_random_nuc_seq(well1024 *rng, unsigned int seq_size)
+void fasta_indexer_line(fasta_indexer *fi, uint64_t end, uint64_t next)
 {
-    assert(seq_size > 0);
-    char *rna_seq = (char*)malloc(seq_size + 1);
-    char nuc[4 + 1] = "AUGC";
-
-    unsigned int i = 0;
-    for (; i < seq_size; ++i)
+    fasta_index *index = fi->index;
+    if (fi->header)
     {
-        rna_seq[i] = nuc[(int)(well1024_next_double(rng) * 4)];
+        fasta_record *r = fasta_index_add(index, fi->name, fi->name_length);
+        r->offset = next;
     }
-    rna_seq[seq_size] = '\0';
-    return rna_seq;
+    else if (index->n > 0)
+    {
+        fasta_record *r = &index->records[index->n - 1];
+        const unsigned int bases = (unsigned int)(end - fi->line_start) - (fi->cr ? 1 : 0);
+        if (r->line_width == 0)
+        {
+            r->line_bases = bases;
+            r->line_width = (unsigned int)(next - fi->line_start);
+        }
+        r->length += bases;
+    }
+    fi->line_start = next;
 }
 
 /**
- * \brief Count the occurences of a char in a string.
- * 
- * \param seq    A sequence. 
- * \return       The number of occurence.
+ * \brief Index the next piece of the file.
+ *
+ * Jumps from line to line with memchr.
+ *
+ * \param fi      The indexer.
+ * \param data    The piece.
+ * \param size    Size of the piece.
+ * \param base    Offset of the piece in the file.
  */
-unsigned int seq_count(const char *seq, const char c)
+void fasta_indexer_feed(fasta_indexer *fi, const char *data, size_t size, uint64_t base)
 {
-    int i = -1;
-    unsigned int count = 0;
-    while (seq[++i] != '\0')
+    size_t pos = 0;
+    while (pos < size)
     {
-        if (seq[i] == c)
+        if (base + pos == fi->line_start)
         {
-            ++count;
+            fi->header = (data[pos] == '>');
+            fi->naming = fi->header;
+            fi->name_length = 0;
+            fi->cr = FALSE;
+            if (fi->header)
+            {
+                ++pos;
+                continue;
+            }
+        }
+        const char *eol = (const char*)memchr(data + pos, '\n', size - pos);
+        const size_t end = (eol == NULL) ? size : (size_t)(eol - data);
+        if (fi->naming)
+        {
+            size_t k = pos;
+            while (k < end && !isspace((unsigned char)data[k]))
+            {
+                ++k;
+            }
+            if (fi->name_length + (k - pos) >= fi->name_capacity)
+            {
+                fi->name_capacity = 2 * (fi->name_length + (k - pos)) + 1;
+                fi->name = (char*)realloc((void*)fi->name, fi->name_capacity);
+            }
+            memcpy(fi->name + fi->name_length, data + pos, k - pos);
+            fi->name_length += k - pos;
+            fi->naming = (k == end && eol == NULL);
+        }
+        if (end > pos)
+        {
+            fi->cr = (data[end - 1] == '\r');
         }
+        if (eol == NULL)
+        {
+            break;
+        }
+        fasta_indexer_line(fi, base + end, base + end + 1);
+        pos = end + 1;
     }
-    return count;
 }
 
 /**
- * \brief Count the number of adenosine 'A' in the sequence.
- * 
- * \param seq    A sequence. 
- * \return       The number of adenosine 'A'.
+ * \brief Account for the last line and free the memory of the indexer.
+ *
+ * \param fi      The indexer.
+ * \param size    Size of the file.
  */
-unsigned int a_count(const char *seq)
+void fasta_indexer_finish(fasta_indexer *fi, uint64_t size)
 {
-    return seq_count(seq, 'A');
+    if (fi->line_start < size)
+    {
+        fasta_indexer_line(fi, size, size);
+    }
+    free(fi->name);
 }
 
 /**
- * \brief Count the number of thymidine 'T' in the sequence.
- * 
- * \param seq    A sequence. 
- * \return       The number of thymidine 'T'.
+ * \brief Build the index of a FASTA file in memory.
+ *
+ * \param index    A pointer to an unitialized 'fasta_index' object.
+ * \param data     Content of the file.
+ * \param size     Size of the file.
  */
-unsigned int t_count(const char *seq)
+void fasta_index_build(fasta_index *index, const char *data, size_t size)
 {
-    return seq_count(seq, 'T');
+    fasta_indexer fi;
+    fasta_indexer_init(&fi, index);
+    fasta_indexer_feed(&fi, data, size, 0);
+    fasta_indexer_finish(&fi, size);
 }
 
 /**
- * \brief Count the number of uracil 'U' in the sequence.
- * 
- * \param seq    A sequence. 
- * \return       The number of uracil 'U'.
+ * \brief Save an index in the .fai format.
+ *
+ * \param index      The index.
+ * \param filename   Name of the index file.
+ * \return           1 (TRUE) if the index has been written.
  */
-unsigned int u_count(const char *seq)
+int fasta_index_save(const fasta_index *index, const char *filename)
 {
-    return seq_count(seq, 'U');
+    FILE *output = fopen(filename, "w");
+    if (output == NULL)
+    {
+        return FALSE;
+    }
+    unsigned int i = 0;
+    for (; i < index->n; ++i)
+    {
+        const fasta_record *r = &index->records[i];
+        fprintf(output, "%s\t%u\t%llu\t%u\t%u\n", r->name, r->length,
+                (unsigned long long)r->offset, r->line_bases, r->line_width);
+    }
+    return fclose(output) == 0;
 }
 
 /**
- * \brief Count the number of guanine 'G' in the sequence.
- * 
- * \param seq    A sequence. 
- * \return       The number of guanine 'G'.
+ * \brief Load an index in the .fai format.
+ *
+ * \param index      A pointer to an unitialized 'fasta_index' object.
+ * \param filename   Name of the index file.
+ * \return           1 (TRUE) if the index has been read.
  */
-unsigned int g_count(const char *seq)
+int fasta_index_load(fasta_index *index, const char *filename)
 {
-    return seq_count(seq, 'G');
-}
+    seq_map m;
 
-/**
- * \brief Count the number of cytosine 'C' in the sequence.
- * 
- * \param seq    A sequence. 
- * \return       The number of cytosine 'C'.
- */
-unsigned int c_count(const char *seq)
-{
-    return seq_count(seq, 'C');
+    index->records = NULL;
+    index->n = 0;
+    index->capacity = 0;
+    if (!seq_map_open(&m, filename))
+    {
+        return FALSE;
+    }
+    size_t pos = 0;
+    while (pos < m.size)
+    {
+        const char *eol = (const char*)memchr(m.data + pos, '\n', m.size - pos);
+        const size_t end = (eol == NULL) ? m.size : (size_t)(eol - m.data);
+        const char *tab = (const char*)memchr(m.data + pos, '\t', end - pos);
+        unsigned long long length, offset;
+        unsigned int line_bases, line_width;
+        char fields[128];
+        int ok = FALSE;
+
+        /* The mapping is not NUL-terminated: parse a bounded copy of the line. */
+        if (tab != NULL && (size_t)(m.data + end - (tab + 1)) < sizeof(fields))
+        {
+            const size_t nfields = m.data + end - (tab + 1);
+            memcpy(fields, tab + 1, nfields);
+            fields[nfields] = '\0';
+            ok = (sscanf(fields, "%llu %llu %u %u", &length, &offset, &line_bases, &line_width) == 4);
+        }
+        if (!ok)
+        {
+            seq_map_close(&m);
+            fasta_index_free(index);
+            return FALSE;
+        }
+        fasta_record *r = fasta_index_add(index, m.data + pos, tab - (m.data + pos));
+        r->length = (unsigned int)length;
+        r->offset = offset;
+        r->line_bases = line_bases;
+        r->line_width = line_width;
+        pos = end + 1;
+    }
+    seq_map_close(&m);
+    return TRUE;
 }
 
 /**
- * \brief Count the number of cytosine 'C' and guanine 'G' in the sequence.
- * 
- * \param seq    A sequence. 
- * \return       The number of cytosine 'C' and guanine 'G'.
+ * \brief Open a FASTA file for random access.
+ *
+ * The index is read from filename.fai if it exists and is not older than the
+ * FASTA file. Otherwise it is built and saved to filename.fai (failing to save
+ * the index is not an error).
+ *
+ * BGZF files are not decompressed: the index of their blocks (filename.gzi) is
+ * used to decompress only the blocks of the records read. Other gzip files are
+ * decompressed in memory and their index is not saved.
+ *
+ * \param ff         A pointer to an unitialized 'fasta_file' object.
+ * \param filename   Name of the FASTA file.
+ * \return           1 (TRUE) if the file has been opened.
  */
-unsigned int gc_count(const char *seq)
+int fasta_open(fasta_file *ff, const char *filename)
 {
-    int i = -1;
-    unsigned int count = 0;
-    while (seq[++i] != '\0')
+    ff->map.data = NULL;
+    ff->map.size = 0;
+    ff->map.owned = FALSE;
+    if (!bgzf_open(&ff->bgzf, filename, 0))
     {
-        count += (seq[i] == 'G' || seq[i] == 'C');
+        return FALSE;
     }
-    return count;
-}
-
-/**
- * \brief Return GC content (number of 'G' + number of 'C') / size.
- * 
- * \param seq    A sequence. 
- * \return       The proportion of cytosine 'C' and guanine 'G'.
+    if (ff->bgzf.format == Gzip)
+    {
+        bgzf_close(&ff->bgzf);
+        if (!seq_map_open(&ff->map, filename))
+        {
+            return FALSE;
+        }
+        fasta_index_build(&ff->index, ff->map.data, ff->map.size);
+        return TRUE;
+    }
+    if (ff->bgzf.format == Plain)
+    {
+        /* Keep the mapping made by bgzf_open. */
+        ff->map.data = (char*)ff->bgzf.cdata;
+        ff->map.size = ff->bgzf.csize;
+        memset(&ff->bgzf, 0, sizeof(bgzf_file));
+    }
+    else if (!bgzf_index(&ff->bgzf, filename))
+    {
+        bgzf_close(&ff->bgzf);
+        return FALSE;
+    }
+
+    char *fai_filename = (char*)malloc(strlen(filename) + 5);
+    sprintf(fai_filename, "%s.fai", filename);
+
+    struct stat st, fai_st;
+    if (stat(filename, &st) == 0 && stat(fai_filename, &fai_st) == 0 &&
+        fai_st.st_mtime >= st.st_mtime && fasta_index_load(&ff->index, fai_filename))
+    {
+        free(fai_filename);
+        return TRUE;
+    }
+    if (ff->bgzf.format == Bgzf)
+    {
+        /* Index while decompressing, without keeping the whole file. */
+        fasta_indexer fi;
+        char *buffer = (char*)malloc(BGZF_BATCH * BGZF_MAX_BLOCK);
+        uint64_t size = 0;
+        size_t n;
+        fasta_indexer_init(&fi, &ff->index);
+        while ((n = bgzf_read(&ff->bgzf, buffer, BGZF_BATCH * BGZF_MAX_BLOCK)) > 0)
+        {
+            fasta_indexer_feed(&fi, buffer, n, size);
+            size += n;
+        }
+        fasta_indexer_finish(&fi, size);
+        free(buffer);
+        if (ff->bgzf.error)
+        {
+            free(fai_filename);
+            fasta_index_free(&ff->index);
+            bgzf_close(&ff->bgzf);
+            return FALSE;
+        }
+    }
+    else
+    {
+        fasta_index_build(&ff->index, ff->map.data, ff->map.size);
+    }
+    fasta_index_save(&ff->index, fai_filename);
+    free(fai_filename);
+    return TRUE;
+}
+
+/**
+ * \brief Close a FASTA file opened with fasta_open.
+ *
+ * \param ff    The FASTA file.
  */
-double gc_content(const char *seq)
+void fasta_close(fasta_file *ff)
 {
-    int i = -1;
-    unsigned int count = 0;
-    while (seq[++i] != '\0')
+    fasta_index_free(&ff->index);
+    seq_map_close(&ff->map);
+    if (ff->bgzf.format == Bgzf)
     {
-        count += (seq[i] == 'G' || seq[i] == 'C');
+        bgzf_close(&ff->bgzf);
     }
-    return (double)count / i;
 }
 
 /**
- * \brief Return TRUE if the sequence is only made of 'G', 'C', 'T' or 'A'.
- * 
- * \param dna_seq    A DNA sequence. 
- * \return           1 (TRUE) if the sequence is made of 'G', 'C', 'T' or 'A'.
+ * \brief Return the residues of the nth record without copying them.
+ *
+ * Only possible when the whole record is on a single line of an uncompressed
+ * file. The pointer is valid until fasta_close and the residues are *not*
+ * NUL-terminated.
+ *
+ * \param ff       The FASTA file.
+ * \param n        Index of the sequence.
+ * \param length   Set to the number of residues.
+ * \return         A pointer to the residues or NULL if the record is wrapped.
  */
-int dna_pure_seq(const char *dna_seq)
+const char *fasta_view(const fasta_file *ff, unsigned int n, unsigned int *length)
 {
-    int i = 0;
-    while (dna_seq[i] != '\0')
+    if (n >= ff->index.n || ff->bgzf.format == Bgzf)
+    {
+        return NULL;
+    }
+    const fasta_record *r = &ff->index.records[n];
+    if (r->length > r->line_bases)
+    {
+        return NULL;
+    }
+    *length = r->length;
+    return ff->map.data + r->offset;
+}
+
+/**
+ * \brief Extract a record from a part of the file.
+ *
+ * \param data    Bytes of the file from 'base' to 'base + size'.
+ * \param base    Offset of 'data' in the file.
+ * \param size    Number of bytes in 'data'.
+ * \param r       The record.
+ * \param seq     A pointer to an unitialized 'sequence' object.
+ * \return        1 (TRUE) if the record was extracted, 0 (FALSE) if its header starts before 'base'.
+ */
+int fasta_extract(const char *data, uint64_t base, size_t size, const fasta_record *r, sequence *seq)
+{
+    /* The header is the line just before the residues. */
+    size_t info_end = (size_t)(r->offset - base);
+    if (info_end > 0 && data[info_end - 1] == '\n')
+    {
+        --info_end;
+    }
+    if (info_end > 0 && data[info_end - 1] == '\r')
+    {
+        --info_end;
+    }
+    size_t info = info_end;
+    while (info > 0 && data[info - 1] != '\n')
+    {
+        --info;
+    }
+    if (info == 0 && base > 0)
+    {
+        return FALSE;
+    }
+    ++info; /* Skip the '>'. */
+    seq->seq_info = (char*)malloc(info_end - info + 1);
+    memcpy(seq->seq_info, data + info, info_end - info);
+    seq->seq_info[info_end - info] = '\0';
+
+    seq->seq = (char*)malloc(r->length + 1);
+    size_t pos = (size_t)(r->offset - base);
+    unsigned int j = 0;
+    while (j < r->length && pos < size)
     {
-        if (DNANUC(dna_seq[i]))
+        const char *eol = (const char*)memchr(data + pos, '\n', size - pos);
+        size_t end = (eol == NULL) ? size : (size_t)(eol - data);
+        const size_t next = end + 1;
+        if (end > pos && data[end - 1] == '\r')
         {
-            ++i;
+            --end;
         }
-        else
+        if (end - pos > r->length - j)
         {
-            return FALSE;
+            end = pos + (r->length - j); /* Stale index. */
         }
+        memcpy(seq->seq + j, data + pos, end - pos);
+        j += (unsigned int)(end - pos);
+        pos = next;
     }
+    seq->seq[j] = '\0';
+    seq->length = j;
     return TRUE;
 }
 
 /**
- * \brief Return TRUE if the sequence is only made of 'G', 'C', 'U' or 'A'.
- * 
- * \param rna_seq    A RNA sequence. 
- * \return           1 (TRUE) if the sequence is made of 'G', 'C', 'U' or 'A'.
+ * \brief Extract the nth sequence from an opened FASTA file.
+ *
+ * \f$O(l)\f$ where \f$l\f$ is the length of the record.
+ *
+ * \param ff     The FASTA file.
+ * \param n      Index of the sequence.
+ * \param seq    A pointer to an unitialized 'sequence' object.
+ * \return       1 (TRUE) if the sequence was found.
  */
-int rna_pure_seq(const char *rna_seq)
+int fasta_get(const fasta_file *ff, unsigned int n, sequence *seq)
 {
-    int i = 0;
-    while (rna_seq[i] != '\0')
+    seq->seq = NULL;
+    seq->seq_info = NULL;
+    seq->length = 0;
+    if (n >= ff->index.n)
+    {
+        return FALSE;
+    }
+    const fasta_record *r = &ff->index.records[n];
+    if (ff->bgzf.format != Bgzf)
+    {
+        return fasta_extract(ff->map.data, 0, ff->map.size, r, seq);
+    }
+
+    /* Decompress the record (the next header is a safe upper bound) and enough before it for the header. */
+    const uint64_t end = (n + 1 < ff->index.n) ? ff->index.records[n + 1].offset : ff->bgzf.usize;
+    uint64_t back = 256;
+    for (;;)
     {
-        if (RNANUC(rna_seq[i]))
+        const uint64_t begin = (r->offset > back) ? r->offset - back : 0;
+        const size_t size = (size_t)((end < ff->bgzf.usize ? end : ff->bgzf.usize) - begin);
+        char *data = (char*)malloc(size + 1);
+        if (!bgzf_read_range(&ff->bgzf, begin, begin + size, data))
         {
-            ++i;
+            free(data);
+            return FALSE;
         }
-        else
+        const int found = fasta_extract(data, begin, size, r, seq);
+        free(data);
+        if (found)
         {
-            return FALSE;
+            return TRUE;
         }
+        back *= 16;
     }
-    return TRUE;
 }
 
 /**
- * \brief Return a sequence with everything removed except 'G', 'C', 'T' and 'A'.
+ * \brief Extract the nth sequence from a file in fasta format.
+ *
+ * Extract a sequence and store it in a sequence object. The file is indexed
+ * (see fasta_open) so the cost does not depend on n once the index exists. To
+ * extract many sequences from the same file, use fasta_open and fasta_get.
  * 
- * \param dna_seq    A DNA sequence. 
- * \return           A DNA sequence without the ambiguities.
+ * \param filename   Name of the input file.
+ * \param n          Index of the sequence (starting at 0).
+ * \param seq        A pointer to an unitialized 'sequence' object.
+ * \return           1 (TRUE) if the sequence was found.
  */
-char *dna_rmv_amb(char *dna_seq)
+int read_fasta(const char *filename, unsigned int n, sequence *seq)
 {
-    char *new_dna_seq = (char*)malloc(strlen(dna_seq));
+    fasta_file ff;
 
-    unsigned int count = 0;
-    int i = 0;
-    for (; dna_seq[i] != '\0'; i++)
+    seq->seq = NULL;
+    seq->seq_info = NULL;
+    seq->length = 0;
+    if (!fasta_open(&ff, filename))
     {
-        if (DNANUC(dna_seq[i]))
-        {
-            new_dna_seq[count++] = dna_seq[i];
-        }
+        return FALSE;
     }
-    new_dna_seq = (char*)realloc((void*)new_dna_seq, count + 1);
-    new_dna_seq[count] = '\0';
+    const int found = fasta_get(&ff, n, seq);
+    fasta_close(&ff);
+    return found;
+}
 
-    return new_dna_seq;
+/**
+ * \brief Size of the input buffer of a fasta_stream.
+ */
+#define FASTA_STREAM_BUFFER 65536
+
+/**
+ * \brief Maximum length of the headers kept by a fasta_stream (longer headers are truncated).
+ */
+#define FASTA_STREAM_INFO 1024
+
+/**
+ * \brief A piece of a record returned by a fasta_stream.
+ */
+typedef struct
+{
+    const char *seq; /**< The residues (NUL-terminated, valid until the next call). */
+
+    unsigned int length; /**< Number of residues in the chunk. */
+
+    const char *info; /**< The header of the record (without the '>'). */
+
+    unsigned int record; /**< Index of the record (starting at 0). */
+
+    uint64_t start; /**< Position of the first residue of the chunk in the record. */
+
+    int first; /**< 1 (TRUE) if this is the first chunk of the record. */
+
+    int last; /**< 1 (TRUE) if this is the last chunk of the record. */
 }
+fasta_chunk;
 
 /**
- * \brief Return a sequence with everything removed except 'G', 'C', 'U' and 'A'.
- * 
- * \param rna_seq    A RNA sequence. 
- * \return           A RNA sequence without the ambiguities.
+ * \brief Read a FASTA file sequentially with a fixed amount of memory.
+ *
+ * Records are returned in chunks of at most 'chunk_size' residues, so a record
+ * shorter than the chunk size comes in a single chunk. The memory used does not
+ * depend on the size of the file or of the records. Compressed files (gzip or
+ * BGZF) are decompressed on the fly. The file is read with 'read', so pipes and
+ * FIFOs can be used as well.
  */
-char *rna_rmv_amb(char *rna_seq)
+typedef struct
 {
-    char *new_rna_seq = (char*)malloc(strlen(rna_seq));
+    bgzf_stream input; /**< The file (compressed or not). */
 
-    unsigned int count = 0;
-    int i = 0;
-    for (; rna_seq[i] != '\0'; i++)
+    char *buffer; /**< Input buffer. */
+
+    size_t pos; /**< Position of the next byte in the buffer. */
+
+    size_t end; /**< Number of bytes in the buffer. */
+
+    int bol; /**< 1 (TRUE) if the next byte starts a line. */
+
+    char *chunk; /**< Residues returned to the user. */
+
+    unsigned int chunk_size; /**< Maximum number of residues in a chunk. */
+
+    char info[FASTA_STREAM_INFO]; /**< Header of the current record. */
+
+    unsigned int nrecords; /**< Number of headers read so far. */
+
+    uint64_t start; /**< Residues of the current record already returned. */
+
+    int in_record; /**< 1 (TRUE) if the residues of the current record are being read. */
+}
+fasta_stream;
+
+/**
+ * \brief Open a FASTA file for sequential reading.
+ *
+ * \param fs           A pointer to an unitialized 'fasta_stream' object.
+ * \param filename     Name of the input file.
+ * \param chunk_size   Maximum number of residues returned at once.
+ * \return             1 (TRUE) if the file has been opened.
+ */
+int fasta_stream_open(fasta_stream *fs, const char *filename, unsigned int chunk_size)
+{
+    assert(chunk_size > 0);
+    if (!bgzf_stream_open(&fs->input, filename))
+    {
+        return FALSE;
+    }
+    fs->buffer = (char*)malloc(FASTA_STREAM_BUFFER);
+    fs->pos = 0;
+    fs->end = 0;
+    fs->bol = TRUE;
+    fs->chunk = (char*)malloc(chunk_size + 1);
+    fs->chunk_size = chunk_size;
+    fs->info[0] = '\0';
+    fs->nrecords = 0;
+    fs->start = 0;
+    fs->in_record = FALSE;
+    return TRUE;
+}
+
+/**
+ * \brief Close a fasta_stream.
+ *
+ * \param fs    The stream.
+ */
+void fasta_stream_close(fasta_stream *fs)
+{
+    bgzf_stream_close(&fs->input);
+    free(fs->buffer);
+    free(fs->chunk);
+}
+
+/**
+ * \brief Make sure the input buffer is not empty.
+ *
+ * \param fs    The stream.
+ * \return      1 (TRUE) if there is at least one byte to read, 0 (FALSE) at the end of the file.
+ */
+int fasta_stream_fill(fasta_stream *fs)
+{
+    if (fs->pos < fs->end)
+    {
+        return TRUE;
+    }
+    fs->pos = 0;
+    fs->end = bgzf_stream_read(&fs->input, fs->buffer, FASTA_STREAM_BUFFER);
+    return fs->end > 0;
+}
+
+/**
+ * \brief Skip to the end of the current line, keeping at most 'max - 1' bytes in 'line'.
+ *
+ * \param fs      The stream.
+ * \param line    Where to copy the line (can be NULL).
+ * \param max     Size of 'line'.
+ */
+void fasta_stream_line(fasta_stream *fs, char *line, size_t max)
+{
+    size_t length = 0;
+    while (fasta_stream_fill(fs))
     {
-        if (RNANUC(rna_seq[i]))
+        const char *eol = (const char*)memchr(fs->buffer + fs->pos, '\n', fs->end - fs->pos);
+        const size_t end = (eol == NULL) ? fs->end : (size_t)(eol - fs->buffer);
+        if (line != NULL && length + 1 < max)
+        {
+            const size_t n = (end - fs->pos < max - 1 - length) ? end - fs->pos : max - 1 - length;
+            memcpy(line + length, fs->buffer + fs->pos, n);
+            length += n;
+        }
+        fs->pos = end;
+        if (eol != NULL)
         {
-            new_rna_seq[count++] = rna_seq[i];
+            ++fs->pos;
+            break;
         }
     }
-    new_rna_seq = (char*)realloc((void*)new_rna_seq, count + 1);
-
-    new_rna_seq[count] = '\0';
-    return new_rna_seq;
+    fs->bol = TRUE;
+    if (line != NULL)
+    {
+        if (length > 0 && line[length - 1] == '\r')
+        {
+            --length;
+        }
+        line[length] = '\0';
+    }
 }
 
 /**
- * \brief Return the antisense strand of a DNA sequence.
- * 
- * \param dna_seq    A DNA sequence. 
- * \return           The antisense strand.
+ * \brief Return the next chunk of residues.
+ *
+ * \param fs       The stream.
+ * \param chunk    Filled with the next chunk.
+ * \return         1 (TRUE) if a chunk was returned, 0 (FALSE) at the end of the file.
  */
-char *dna_antisense(const char *dna_seq)
+int fasta_stream_next(fasta_stream *fs, fasta_chunk *chunk)
 {
-    assert(dna_pure_seq(dna_seq));
-    const int seq_len = strlen(dna_seq);
-    char *dna_antisense = (char*)malloc(seq_len + 1);
+    if (!fs->in_record)
+    {
+        /* Skip everything up to the next header. */
+        for (;;)
+        {
+            if (!fasta_stream_fill(fs))
+            {
+                return FALSE;
+            }
+            if (fs->bol && fs->buffer[fs->pos] == '>')
+            {
+                break;
+            }
+            fasta_stream_line(fs, NULL, 0);
+        }
+        ++fs->pos;
+        fasta_stream_line(fs, fs->info, FASTA_STREAM_INFO);
+        ++fs->nrecords;
+        fs->start = 0;
+        fs->in_record = TRUE;
+    }
 
-    int i = 0;
-    for (; i < seq_len; ++i)
+    unsigned int length = 0;
+    int last = FALSE;
+    while (length < fs->chunk_size)
     {
-        if (dna_seq[i] == 'T')
+        if (!fasta_stream_fill(fs))
         {
-            dna_antisense[seq_len - 1 - i] = 'A';
+            last = TRUE;
+            break;
         }
-        else if (dna_seq[i] == 'A')
+        const char c = fs->buffer[fs->pos];
+        if (c == '\n' || c == '\r')
         {
-            dna_antisense[seq_len - 1 - i] = 'T';
+            fs->bol = (c == '\n');
+            ++fs->pos;
+            continue;
         }
-        else if (dna_seq[i] == 'G')
+        if (fs->bol && c == '>')
         {
-            dna_antisense[seq_len - 1 - i] = 'C';
+            last = TRUE;
+            break;
         }
-        else
+        /* Copy the rest of the line (or what fits in the chunk). */
+        const char *eol = (const char*)memchr(fs->buffer + fs->pos, '\n', fs->end - fs->pos);
+        size_t end = (eol == NULL) ? fs->end : (size_t)(eol - fs->buffer);
+        if (end - fs->pos > fs->chunk_size - length)
+        {
+            end = fs->pos + (fs->chunk_size - length);
+        }
+        if (end > fs->pos && fs->buffer[end - 1] == '\r')
         {
-            dna_antisense[seq_len - 1 - i] = 'G';
+            --end;
         }
+        memcpy(fs->chunk + length, fs->buffer + fs->pos, end - fs->pos);
+        length += (unsigned int)(end - fs->pos);
+        fs->pos = end;
+        fs->bol = FALSE;
     }
-    dna_antisense[seq_len] = '\0';
-    return dna_antisense;
+
+    if (!last)
+    {
+        /* Look ahead to know if the record continues. */
+        for (;;)
+        {
+            if (!fasta_stream_fill(fs))
+            {
+                last = TRUE;
+                break;
+            }
+            const char c = fs->buffer[fs->pos];
+            if (c != '\n' && c != '\r')
+            {
+                last = (fs->bol && c == '>');
+                break;
+            }
+            fs->bol = (c == '\n');
+            ++fs->pos;
+        }
+    }
+
+    fs->chunk[length] = '\0';
+    chunk->seq = fs->chunk;
+    chunk->length = length;
+    chunk->info = fs->info;
+    chunk->record = fs->nrecords - 1;
+    chunk->start = fs->start;
+    chunk->first = (fs->start == 0);
+    chunk->last = last;
+
+    fs->start += length;
+    fs->in_record = !last;
+    return TRUE;
 }
 
 /**
- * \brief DNA -> RNA.
+ * \brief Append the residues of a text node to a sequence, skipping whitespace.
  *
- * Start reading when encountering a start codon. Both the DNA sequence and the
- * resulting RNA sequence are in the 5' -> 3' direction.
- * 
- * \param dna_seq    A DNA sequence. 
- * \return           RNA sequence resulting from transcription.
+ * \param seq        The sequence being built.
+ * \param capacity   Capacity of seq->seq.
+ * \param text       The text to append.
  */
-char* transcription(const char* dna_seq)
+void sequenceml_append(sequence *seq, unsigned int *capacity, const char *text)
 {
-    assert(dna_pure_seq(dna_seq));
-    const int seq_len = strlen(dna_seq);
-    char* rna_seq = (char*)malloc(seq_len + 1);
-
-    int i = 0;
-    for (; i < seq_len; ++i)
+    const size_t length = strlen(text);
+    if (seq->length + length + 1 > *capacity)
     {
-        if (dna_seq[i] == 'T')
+        while (seq->length + length + 1 > *capacity)
         {
-            rna_seq[i] = 'U';
+            *capacity *= 2;
         }
-        else
+        seq->seq = (char*)realloc((void*)seq->seq, *capacity);
+    }
+    size_t i = 0;
+    for (; i < length; ++i)
+    {
+        if (!isspace((unsigned char)text[i]))
         {
-            rna_seq[i] = dna_seq[i];
+            seq->seq[seq->length++] = text[i];
         }
     }
-    rna_seq[seq_len] = '\0';
-    return rna_seq;
+    seq->seq[seq->length] = '\0';
 }
 
 /**
- * \brief Translate RNA to an amino acid sequence.
+ * \brief Extract the nth sequence from a file in sequenceml format.
  *
- * \param dna_seq    A RNA sequence. 
- * \return           A sequence of amino acids.
+ * Extract a sequence and store it in a sequence object. The file is read with
+ * libxml2's streaming reader: the sequences before the nth are skipped without
+ * building their nodes and only the residues of the nth sequence are kept.
+ *
+ * The nth 'sequence' element is used. Its 'id' (or 'name') attribute becomes
+ * the info and the residues are the text inside its 'seq' or 'residues'
+ * children (or the text directly inside the element), without whitespace.
+ * 
+ * \param filename   Name of the input file.
+ * \param n          Index of the sequence (starting at 0).
+ * \param seq        A pointer to an unitialized 'sequence' object.
+ * \return           1 (TRUE) if the sequence was found.
  */
-char *translation(const char *rna_seq)
+int read_sequenceml(const char *filename, unsigned int n, sequence *seq)
 {
-    assert(rna_pure_seq(rna_seq));
-    const unsigned int n_amino = strlen(rna_seq) / 3;
-    char* amino_seq = (char*)malloc(n_amino + 1);
+    seq->seq = NULL;
+    seq->seq_info = NULL;
+    seq->length = 0;
 
-    unsigned int i = 0, a = 0;
-    while (a < n_amino)
+    xmlTextReaderPtr reader = xmlReaderForFile(filename, NULL, XML_PARSE_NONET);
+    if (reader == NULL)
     {
-#ifdef CUSTOMCODE
-        if (rna_seq[i] == 'U')
+        return FALSE;
+    }
+
+    unsigned int count = 0;
+    int found = FALSE;
+    int ret = xmlTextReaderRead(reader);
+    while (ret == 1)
+    {
+        if (xmlTextReaderNodeType(reader) == XML_READER_TYPE_ELEMENT &&
+            xmlStrEqual(xmlTextReaderConstLocalName(reader), BAD_CAST "sequence"))
         {
-            if (rna_seq[i + 1] == 'U')
+            if (count < n)
             {
-                if (rna_seq[i + 2] == 'U')
-                {
-                    amino_seq[a] = GCODE_UUU;
-                }
-                else if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = GCODE_UUG;
-                }
-                else if (rna_seq[i + 2] == 'C')
+                /* Skip the whole subtree. */
+                ++count;
+                ret = xmlTextReaderNext(reader);
+                continue;
+            }
+            found = TRUE;
+            break;
+        }
+        ret = xmlTextReaderRead(reader);
+    }
+    if (!found)
+    {
+        xmlFreeTextReader(reader);
+        return FALSE;
+    }
+
+    xmlChar *info = xmlTextReaderGetAttribute(reader, BAD_CAST "id");
+    if (info == NULL)
+    {
+        info = xmlTextReaderGetAttribute(reader, BAD_CAST "name");
+    }
+    const char *id = (info == NULL) ? "" : (const char*)info;
+    const size_t id_length = strlen(id);
+    seq->seq_info = (char*)malloc(id_length + 1);
+    memcpy(seq->seq_info, id, id_length + 1);
+    xmlFree(info);
+
+    unsigned int capacity = 1024;
+    seq->seq = (char*)malloc(capacity);
+    seq->seq[0] = '\0';
+
+    if (!xmlTextReaderIsEmptyElement(reader))
+    {
+        const int depth = xmlTextReaderDepth(reader);
+        int residues_depth = -1; /* Depth of the 'seq' element we are in, if any. */
+
+        while ((ret = xmlTextReaderRead(reader)) == 1)
+        {
+            const int type = xmlTextReaderNodeType(reader);
+            const int d = xmlTextReaderDepth(reader);
+
+            if (type == XML_READER_TYPE_END_ELEMENT)
+            {
+                if (d == depth)
                 {
-                    amino_seq[a] = GCODE_UUC;
+                    break;
                 }
-                else
+                if (d == residues_depth)
                 {
-                    amino_seq[a] = GCODE_UUA;
+                    residues_depth = -1;
                 }
             }
-            else if (rna_seq[i + 1] == 'G')
+            else if (type == XML_READER_TYPE_ELEMENT)
             {
-                if (rna_seq[i + 2] == 'U')
+                const xmlChar *name = xmlTextReaderConstLocalName(reader);
+                if (residues_depth < 0 && !xmlTextReaderIsEmptyElement(reader) &&
+                    (xmlStrEqual(name, BAD_CAST "seq") || xmlStrEqual(name, BAD_CAST "residues")))
                 {
-                    amino_seq[a] = GCODE_UGU;
-                }
-                else if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = GCODE_UGG;
-                }
-                else if (rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = GCODE_UGC;
-                }
-                else
-                {
-                    amino_seq[a] = GCODE_UGA;
-                }
-            }
-            else if (rna_seq[i + 1] == 'C')
-            {
-                if (rna_seq[i + 2] == 'U')
-                {
-                    amino_seq[a] = GCODE_UCU;
-                }
-                else if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = GCODE_UCG;
-                }
-                else if (rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = GCODE_UCC;
-                }
-                else
-                {
-                    amino_seq[a] = GCODE_UCA;
+                    residues_depth = d;
                 }
             }
-            else
+            else if ((type == XML_READER_TYPE_TEXT || type == XML_READER_TYPE_CDATA) &&
+                     (residues_depth >= 0 || d == depth + 1))
             {
-                if (rna_seq[i + 2] == 'U')
-                {
-                    amino_seq[a] = GCODE_UAU;
-                }
-                else if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = GCODE_UAG;
-                }
-                else if (rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = GCODE_UAC;
-                }
-                else
-                {
-                    amino_seq[a] = GCODE_UAA;
-                }
+                sequenceml_append(seq, &capacity, (const char*)xmlTextReaderConstValue(reader));
             }
         }
-        else if (rna_seq[i] == 'G')
+    }
+    xmlFreeTextReader(reader);
+    if (ret < 0)
+    {
+        free(seq->seq);
+        free(seq->seq_info);
+        seq->seq = NULL;
+        seq->seq_info = NULL;
+        seq->length = 0;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * \brief Layout of a flat file format (EMBL or GenBank).
+ */
+typedef struct
+{
+    const char *info_tag; /**< Tag of the description lines ("DE" or "DEFINITION"). */
+
+    const char *seq_tag; /**< Tag of the line starting the residues ("SQ" or "ORIGIN"). */
+
+    unsigned int info_col; /**< Column where the description starts. */
+
+    unsigned int seq_col; /**< Column of the first residue on a residue line. */
+
+    unsigned int full_line; /**< Length of a residue line with 60 residues. */
+}
+flat_format;
+
+#if defined(__SSSE3__)
+/**
+ * \brief Shuffles moving the bytes selected by an 8-bit mask to the front.
+ */
+static const uint64_t compact_shuffle[256] =
+{
+    0x8080808080808080ULL, 0x8080808080808000ULL, 0x8080808080808001ULL, 0x8080808080800100ULL,
+    0x8080808080808002ULL, 0x8080808080800200ULL, 0x8080808080800201ULL, 0x8080808080020100ULL,
+    0x8080808080808003ULL, 0x8080808080800300ULL, 0x8080808080800301ULL, 0x8080808080030100ULL,
+    0x8080808080800302ULL, 0x8080808080030200ULL, 0x8080808080030201ULL, 0x8080808003020100ULL,
+    0x8080808080808004ULL, 0x8080808080800400ULL, 0x8080808080800401ULL, 0x8080808080040100ULL,
+    0x8080808080800402ULL, 0x8080808080040200ULL, 0x8080808080040201ULL, 0x8080808004020100ULL,
+    0x8080808080800403ULL, 0x8080808080040300ULL, 0x8080808080040301ULL, 0x8080808004030100ULL,
+    0x8080808080040302ULL, 0x8080808004030200ULL, 0x8080808004030201ULL, 0x8080800403020100ULL,
+    0x8080808080808005ULL, 0x8080808080800500ULL, 0x8080808080800501ULL, 0x8080808080050100ULL,
+    0x8080808080800502ULL, 0x8080808080050200ULL, 0x8080808080050201ULL, 0x8080808005020100ULL,
+    0x8080808080800503ULL, 0x8080808080050300ULL, 0x8080808080050301ULL, 0x8080808005030100ULL,
+    0x8080808080050302ULL, 0x8080808005030200ULL, 0x8080808005030201ULL, 0x8080800503020100ULL,
+    0x8080808080800504ULL, 0x8080808080050400ULL, 0x8080808080050401ULL, 0x8080808005040100ULL,
+    0x8080808080050402ULL, 0x8080808005040200ULL, 0x8080808005040201ULL, 0x8080800504020100ULL,
+    0x8080808080050403ULL, 0x8080808005040300ULL, 0x8080808005040301ULL, 0x8080800504030100ULL,
+    0x8080808005040302ULL, 0x8080800504030200ULL, 0x8080800504030201ULL, 0x8080050403020100ULL,
+    0x8080808080808006ULL, 0x8080808080800600ULL, 0x8080808080800601ULL, 0x8080808080060100ULL,
+    0x8080808080800602ULL, 0x8080808080060200ULL, 0x8080808080060201ULL, 0x8080808006020100ULL,
+    0x8080808080800603ULL, 0x8080808080060300ULL, 0x8080808080060301ULL, 0x8080808006030100ULL,
+    0x8080808080060302ULL, 0x8080808006030200ULL, 0x8080808006030201ULL, 0x8080800603020100ULL,
+    0x8080808080800604ULL, 0x8080808080060400ULL, 0x8080808080060401ULL, 0x8080808006040100ULL,
+    0x8080808080060402ULL, 0x8080808006040200ULL, 0x8080808006040201ULL, 0x8080800604020100ULL,
+    0x8080808080060403ULL, 0x8080808006040300ULL, 0x8080808006040301ULL, 0x8080800604030100ULL,
+    0x8080808006040302ULL, 0x8080800604030200ULL, 0x8080800604030201ULL, 0x8080060403020100ULL,
+    0x8080808080800605ULL, 0x8080808080060500ULL, 0x8080808080060501ULL, 0x8080808006050100ULL,
+    0x8080808080060502ULL, 0x8080808006050200ULL, 0x8080808006050201ULL, 0x8080800605020100ULL,
+    0x8080808080060503ULL, 0x8080808006050300ULL, 0x8080808006050301ULL, 0x8080800605030100ULL,
+    0x8080808006050302ULL, 0x8080800605030200ULL, 0x8080800605030201ULL, 0x8080060503020100ULL,
+    0x8080808080060504ULL, 0x8080808006050400ULL, 0x8080808006050401ULL, 0x8080800605040100ULL,
+    0x8080808006050402ULL, 0x8080800605040200ULL, 0x8080800605040201ULL, 0x8080060504020100ULL,
+    0x8080808006050403ULL, 0x8080800605040300ULL, 0x8080800605040301ULL, 0x8080060504030100ULL,
+    0x8080800605040302ULL, 0x8080060504030200ULL, 0x8080060504030201ULL, 0x8006050403020100ULL,
+    0x8080808080808007ULL, 0x8080808080800700ULL, 0x8080808080800701ULL, 0x8080808080070100ULL,
+    0x8080808080800702ULL, 0x8080808080070200ULL, 0x8080808080070201ULL, 0x8080808007020100ULL,
+    0x8080808080800703ULL, 0x8080808080070300ULL, 0x8080808080070301ULL, 0x8080808007030100ULL,
+    0x8080808080070302ULL, 0x8080808007030200ULL, 0x8080808007030201ULL, 0x8080800703020100ULL,
+    0x8080808080800704ULL, 0x8080808080070400ULL, 0x8080808080070401ULL, 0x8080808007040100ULL,
+    0x8080808080070402ULL, 0x8080808007040200ULL, 0x8080808007040201ULL, 0x8080800704020100ULL,
+    0x8080808080070403ULL, 0x8080808007040300ULL, 0x8080808007040301ULL, 0x8080800704030100ULL,
+    0x8080808007040302ULL, 0x8080800704030200ULL, 0x8080800704030201ULL, 0x8080070403020100ULL,
+    0x8080808080800705ULL, 0x8080808080070500ULL, 0x8080808080070501ULL, 0x8080808007050100ULL,
+    0x8080808080070502ULL, 0x8080808007050200ULL, 0x8080808007050201ULL, 0x8080800705020100ULL,
+    0x8080808080070503ULL, 0x8080808007050300ULL, 0x8080808007050301ULL, 0x8080800705030100ULL,
+    0x8080808007050302ULL, 0x8080800705030200ULL, 0x8080800705030201ULL, 0x8080070503020100ULL,
+    0x8080808080070504ULL, 0x8080808007050400ULL, 0x8080808007050401ULL, 0x8080800705040100ULL,
+    0x8080808007050402ULL, 0x8080800705040200ULL, 0x8080800705040201ULL, 0x8080070504020100ULL,
+    0x8080808007050403ULL, 0x8080800705040300ULL, 0x8080800705040301ULL, 0x8080070504030100ULL,
+    0x8080800705040302ULL, 0x8080070504030200ULL, 0x8080070504030201ULL, 0x8007050403020100ULL,
+    0x8080808080800706ULL, 0x8080808080070600ULL, 0x8080808080070601ULL, 0x8080808007060100ULL,
+    0x8080808080070602ULL, 0x8080808007060200ULL, 0x8080808007060201ULL, 0x8080800706020100ULL,
+    0x8080808080070603ULL, 0x8080808007060300ULL, 0x8080808007060301ULL, 0x8080800706030100ULL,
+    0x8080808007060302ULL, 0x8080800706030200ULL, 0x8080800706030201ULL, 0x8080070603020100ULL,
+    0x8080808080070604ULL, 0x8080808007060400ULL, 0x8080808007060401ULL, 0x8080800706040100ULL,
+    0x8080808007060402ULL, 0x8080800706040200ULL, 0x8080800706040201ULL, 0x8080070604020100ULL,
+    0x8080808007060403ULL, 0x8080800706040300ULL, 0x8080800706040301ULL, 0x8080070604030100ULL,
+    0x8080800706040302ULL, 0x8080070604030200ULL, 0x8080070604030201ULL, 0x8007060403020100ULL,
+    0x8080808080070605ULL, 0x8080808007060500ULL, 0x8080808007060501ULL, 0x8080800706050100ULL,
+    0x8080808007060502ULL, 0x8080800706050200ULL, 0x8080800706050201ULL, 0x8080070605020100ULL,
+    0x8080808007060503ULL, 0x8080800706050300ULL, 0x8080800706050301ULL, 0x8080070605030100ULL,
+    0x8080800706050302ULL, 0x8080070605030200ULL, 0x8080070605030201ULL, 0x8007060503020100ULL,
+    0x8080808007060504ULL, 0x8080800706050400ULL, 0x8080800706050401ULL, 0x8080070605040100ULL,
+    0x8080800706050402ULL, 0x8080070605040200ULL, 0x8080070605040201ULL, 0x8007060504020100ULL,
+    0x8080800706050403ULL, 0x8080070605040300ULL, 0x8080070605040301ULL, 0x8007060504030100ULL,
+    0x8080070605040302ULL, 0x8007060504030200ULL, 0x8007060504030201ULL, 0x0706050403020100ULL
+};
+
+/**
+ * \brief Write the bytes of v selected by a 16-bit mask at dst, packed to the left.
+ *
+ * Up to 16 bytes are written, the ones after the bytes kept are garbage.
+ *
+ * \return    Number of bytes kept.
+ */
+size_t compact_16(__m128i v, int mask, char *dst)
+{
+    const __m128i lo = _mm_shuffle_epi8(v, _mm_loadl_epi64((const __m128i*)&compact_shuffle[mask & 0xff]));
+    _mm_storel_epi64((__m128i*)dst, lo);
+    const size_t count = cseq_popcount((uint64_t)(mask & 0xff));
+    const __m128i hi = _mm_shuffle_epi8(_mm_srli_si128(v, 8),
+                                        _mm_loadl_epi64((const __m128i*)&compact_shuffle[mask >> 8]));
+    _mm_storel_epi64((__m128i*)(dst + count), hi);
+    return count + cseq_popcount((uint64_t)(mask >> 8));
+}
+#endif
+
+/**
+ * \brief Copy the residues of a line, uppercased, skipping everything else.
+ *
+ * With SSSE3, the letters of 16 bytes are found, uppercased and packed to the
+ * left at once (see compact_16).
+ *
+ * \param dst      Where to write the residues, with room for 'length' bytes.
+ * \param line     The line.
+ * \param length   Length of the line.
+ * \return         Number of residues written.
+ */
+unsigned int flat_filter(char *dst, const char *line, size_t length)
+{
+    unsigned int count = 0;
+    size_t i = 0;
+#if defined(__SSSE3__)
+    /* Letters are the bytes with (c | 0x20) - 'a' < 26 (unsigned). */
+    for (; i + 16 <= length; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(line + i));
+        const __m128i x = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+        const __m128i letters = _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(25)), x);
+        const __m128i upper = _mm_andnot_si128(_mm_set1_epi8(0x20), v);
+        count += (unsigned int)compact_16(upper, _mm_movemask_epi8(letters), dst + count);
+    }
+#endif
+    for (; i < length; ++i)
+    {
+        const unsigned char c = (unsigned char)line[i];
+        dst[count] = (char)(c & ~0x20);
+        count += ((unsigned char)((c | 0x20) - 'a') < 26);
+    }
+    return count;
+}
+
+/**
+ * \brief Uppercase residues in place.
+ *
+ * The loop has no branch so compilers vectorize it.
+ *
+ * \param seq      The residues.
+ * \param length   Number of residues.
+ * \return         1 (TRUE) if all the bytes were letters.
+ */
+int flat_upper(char *seq, size_t length)
+{
+    unsigned char bad = 0;
+    size_t i = 0;
+    for (; i < length; ++i)
+    {
+        const unsigned char c = (unsigned char)seq[i];
+        bad |= ((unsigned char)((c | 0x20) - 'a') >= 26);
+        seq[i] = (char)(c & ~0x20);
+    }
+    return !bad;
+}
+
+/**
+ * \brief Return TRUE if a line starts with a tag followed by a space (or nothing).
+ */
+int flat_tag(const char *line, size_t length, const char *tag)
+{
+    const size_t tlength = strlen(tag);
+    return length >= tlength && memcmp(line, tag, tlength) == 0 &&
+           (length == tlength || line[tlength] == ' ' || line[tlength] == '\r');
+}
+
+/**
+ * \brief Extract the nth record of a flat file (EMBL or GenBank).
+ *
+ * One pass over the mapped file. Records before the nth are skipped by looking
+ * only at the start of the lines and the feature table is never parsed. The
+ * residue lines written with the standard layout (six blocks of ten residues)
+ * are copied block by block straight from the file, other lines go through a
+ * branchless filter.
+ *
+ * \param filename   Name of the input file.
+ * \param n          Index of the sequence (starting at 0).
+ * \param seq        A pointer to an unitialized 'sequence' object.
+ * \param format     Layout of the file.
+ * \return           1 (TRUE) if the sequence was found.
+ */
+int read_flat(const char *filename, unsigned int n, sequence *seq, const flat_format *format)
+{
+    seq_map m;
+
+    seq->seq = NULL;
+    seq->seq_info = NULL;
+    seq->length = 0;
+    if (!seq_map_open(&m, filename))
+    {
+        return FALSE;
+    }
+    const char *data = m.data;
+    const size_t size = m.size;
+    size_t pos = 0;
+
+    /* Skip n records by looking for the lines starting with "//". */
+    unsigned int count = 0;
+    while (count < n && pos < size)
+    {
+        const char *slash = (const char*)memchr(data + pos, '/', size - pos);
+        if (slash == NULL)
         {
-            if (rna_seq[i + 1] == 'U')
-            {
-                if (rna_seq[i + 2] == 'U')
-                {
-                    amino_seq[a] = GCODE_GUU;
-                }
-                else if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = GCODE_GUG;
-                }
-                else if (rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = GCODE_GUC;
-                }
-                else
-                {
-                    amino_seq[a] = GCODE_GUA;
-                }
-            }
-            else if (rna_seq[i + 1] == 'G')
-            {
-                if (rna_seq[i + 2] == 'U')
-                {
-                    amino_seq[a] = GCODE_GGU;
-                }
-                else if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = GCODE_GGG;
-                }
-                else if (rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = GCODE_GGC;
-                }
-                else
-                {
-                    amino_seq[a] = GCODE_GGA;
-                }
-            }
-            else if (rna_seq[i + 1] == 'C')
-            {
-                if (rna_seq[i + 2] == 'U')
-                {
-                    amino_seq[a] = GCODE_GCU;
-                }
-                else if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = GCODE_GCG;
-                }
-                else if (rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = GCODE_GCC;
-                }
-                else
-                {
-                    amino_seq[a] = GCODE_GCA;
-                }
-            }
-            else
-            {
-                if (rna_seq[i + 2] == 'U')
-                {
-                    amino_seq[a] = GCODE_GAU;
-                }
-                else if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = GCODE_GAG;
-                }
-                else if (rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = GCODE_GAC;
-                }
-                else
-                {
-                    amino_seq[a] = GCODE_GAA;
-                }
-            }
+            pos = size;
+            break;
         }
-        else if (rna_seq[i] == 'C')
+        const size_t i = (size_t)(slash - data);
+        if ((i == 0 || data[i - 1] == '\n') && i + 1 < size && data[i + 1] == '/')
         {
-            if (rna_seq[i + 1] == 'U')
-            {
-                if (rna_seq[i + 2] == 'U')
-                {
-                    amino_seq[a] = GCODE_CUU;
-                }
-                else if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = GCODE_CUG;
-                }
-                else if (rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = GCODE_CUC;
-                }
-                else
-                {
-                    amino_seq[a] = GCODE_CUA;
-                }
-            }
-            else if (rna_seq[i + 1] == 'G')
-            {
-                if (rna_seq[i + 2] == 'U')
-                {
-                    amino_seq[a] = GCODE_CGU;
-                }
-                else if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = GCODE_CGG;
-                }
-                else if (rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = GCODE_CGC;
-                }
-                else
-                {
-                    amino_seq[a] = GCODE_CGA;
-                }
-            }
-            else if (rna_seq[i + 1] == 'C')
-            {
-                if (rna_seq[i + 2] == 'U')
-                {
-                    amino_seq[a] = GCODE_CCU;
-                }
-                else if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = GCODE_CCG;
-                }
-                else if (rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = GCODE_CCC;
-                }
-                else
-                {
-                    amino_seq[a] = GCODE_CCA;
-                }
-            }
-            else
-            {
-                if (rna_seq[i + 2] == 'U')
-                {
-                    amino_seq[a] = GCODE_CAU;
-                }
-                else if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = GCODE_CAG;
-                }
-                else if (rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = GCODE_CAC;
-                }
-                else
-                {
-                    amino_seq[a] = GCODE_CAA;
-                }
-            }
+            ++count;
+            const char *eol = (const char*)memchr(data + i, '\n', size - i);
+            pos = (eol == NULL) ? size : (size_t)(eol - data) + 1;
         }
         else
         {
-            if (rna_seq[i + 1] == 'U')
-            {
-                if (rna_seq[i + 2] == 'U')
-                {
-                    amino_seq[a] = GCODE_AUU;
-                }
-                else if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = GCODE_AUG;
-                }
-                else if (rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = GCODE_AUC;
-                }
-                else
-                {
-                    amino_seq[a] = GCODE_AUA;
-                }
-            }
-            else if (rna_seq[i + 1] == 'G')
-            {
-                if (rna_seq[i + 2] == 'U')
-                {
-                    amino_seq[a] = GCODE_AGU;
-                }
-                else if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = GCODE_AGG;
-                }
-                else if (rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = GCODE_AGC;
-                }
-                else
-                {
-                    amino_seq[a] = GCODE_AGA;
-                }
-            }
-            else if (rna_seq[i + 1] == 'C')
-            {
-                if (rna_seq[i + 2] == 'U')
-                {
-                    amino_seq[a] = GCODE_ACU;
-                }
-                else if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = GCODE_ACG;
-                }
-                else if (rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = GCODE_ACC;
-                }
-                else
-                {
-                    amino_seq[a] = GCODE_ACA;
-                }
-            }
-            else
-            {
-                if (rna_seq[i + 2] == 'U')
-                {
-                    amino_seq[a] = GCODE_AAU;
-                }
-                else if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = GCODE_AAG;
-                }
-                else if (rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = GCODE_AAC;
-                }
-                else
-                {
-                    amino_seq[a] = GCODE_AAA;
-                }
-            }
+            pos = i + 1;
         }
-#else
-        if (rna_seq[i] == 'U')
+    }
+
+    /* Header of the record: description and start of the residues. */
+    size_t info_capacity = 256;
+    size_t info_length = 0;
+    int in_info = FALSE;
+    int found = FALSE;
+    seq->seq_info = (char*)malloc(info_capacity);
+    while (pos < size)
+    {
+        const char *eol = (const char*)memchr(data + pos, '\n', size - pos);
+        const size_t next = (eol == NULL) ? size : (size_t)(eol - data) + 1;
+        size_t end = (eol == NULL) ? size : next - 1;
+        if (end > pos && data[end - 1] == '\r')
         {
-            if (rna_seq[i + 1] == 'U')
-            {
-                if (rna_seq[i + 2] == 'U' || rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = 'F';
-                }
-                else
-                {
-                    amino_seq[a] = 'L';
-                }
-            }
-            else if (rna_seq[i + 1] == 'C')
+            --end;
+        }
+        const char *line = data + pos;
+        const size_t length = end - pos;
+        pos = next;
+
+        if (length >= 2 && line[0] == '/' && line[1] == '/')
+        {
+            break;
+        }
+        if (flat_tag(line, length, format->seq_tag))
+        {
+            found = TRUE;
+            break;
+        }
+        /* GenBank continues the description on lines starting with spaces, EMBL repeats the tag. */
+        const int continued = in_info && length > format->info_col && line[0] == ' ';
+        in_info = continued || flat_tag(line, length, format->info_tag);
+        if (in_info && length > format->info_col)
+        {
+            const size_t add = length - format->info_col;
+            if (info_length + add + 2 > info_capacity)
             {
-                amino_seq[a] = 'S';
+                info_capacity = 2 * (info_length + add + 2);
+                seq->seq_info = (char*)realloc((void*)seq->seq_info, info_capacity);
             }
-            else if (rna_seq[i + 1] == 'A')
+            if (info_length > 0)
             {
-                if (rna_seq[i + 2] == 'U' || rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = 'Y';
-                }
-                else
-                {
-                    amino_seq[a] = 'Z';
-                }
+                seq->seq_info[info_length++] = ' ';
             }
-            else
+            size_t first = format->info_col;
+            while (first < length && line[first] == ' ')
             {
-                if (rna_seq[i + 2] == 'U' || rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = 'C';
-                }
-                else if (rna_seq[i + 2] == 'A')
-                {
-                    amino_seq[a] = 'Z';
-                }
-                else
-                {
-                    amino_seq[a] = 'W';
-                }
+                ++first;
             }
+            memcpy(seq->seq_info + info_length, line + first, length - first);
+            info_length += length - first;
+        }
+    }
+    seq->seq_info[info_length] = '\0';
+    if (!found)
+    {
+        seq_map_close(&m);
+        free(seq->seq_info);
+        seq->seq_info = NULL;
+        return FALSE;
+    }
+
+    /* Find the end of the residues to size the sequence. */
+    const size_t start = pos;
+    while (pos < size && !(data[pos] == '/' && pos + 1 < size && data[pos + 1] == '/'))
+    {
+        const char *eol = (const char*)memchr(data + pos, '\n', size - pos);
+        pos = (eol == NULL) ? size : (size_t)(eol - data) + 1;
+    }
+    const size_t stop = pos;
+    seq->seq = (char*)malloc(stop - start + 1);
+
+    unsigned int length = 0;
+    pos = start;
+    while (pos < stop)
+    {
+        const char *eol = (const char*)memchr(data + pos, '\n', stop - pos);
+        const size_t next = (eol == NULL) ? stop : (size_t)(eol - data) + 1;
+        size_t end = (eol == NULL) ? stop : next - 1;
+        if (end > pos && data[end - 1] == '\r')
+        {
+            --end;
         }
-        else if (rna_seq[i] == 'C')
+        const char *line = data + pos;
+        const size_t line_length = end - pos;
+        char *dst = seq->seq + length;
+        pos = next;
+
+        if (line_length >= format->full_line && line[format->seq_col - 1] == ' ' &&
+            line[format->seq_col + 10] == ' ' && line[format->seq_col + 54] == ' ')
         {
-            if (rna_seq[i + 1] == 'U')
+            /* Standard layout: six blocks of ten residues separated by spaces. */
+            unsigned int k = 0;
+            for (; k < 6; ++k)
             {
-                amino_seq[a] = 'L';
+                memcpy(dst + 10 * k, line + format->seq_col + 11 * k, 10);
             }
-            else if (rna_seq[i + 1] == 'C')
+            if (flat_upper(dst, 60))
             {
-                amino_seq[a] = 'P';
+                length += 60;
+                continue;
             }
-            else if (rna_seq[i + 1] == 'A')
-            {
-                if (rna_seq[i + 2] == 'U' || rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = 'H';
+        }
+        length += flat_filter(dst, line, line_length);
+    }
+    seq->seq[length] = '\0';
+    seq->seq = (char*)realloc((void*)seq->seq, length + 1);
+    seq->length = length;
+    seq_map_close(&m);
+    return TRUE;
+}
+
+/**
+ * \brief Extract the nth sequence from a file in EMBL format.
+ *
+ * Extract a sequence and store it in a sequence object. The info is the
+ * description (DE lines) and the residues are uppercased. See read_flat.
+ * 
+ * \param filename   Name of the input file.
+ * \param n          Index of the sequence (starting at 0).
+ * \param seq        A pointer to an unitialized 'sequence' object.
+ * \return           1 (TRUE) if the sequence was found.
+ */
+int read_embl(const char *filename, unsigned int n, sequence *seq)
+{
+    flat_format format;
+    format.info_tag = "DE";
+    format.seq_tag = "SQ";
+    format.info_col = 5;
+    format.seq_col = 5;
+    format.full_line = 70;
+    return read_flat(filename, n, seq, &format);
+}
+
+/**
+ * \brief Extract the nth sequence from a file in genbank format.
+ *
+ * Extract a sequence and store it in a sequence object. The info is the
+ * definition (DEFINITION lines) and the residues are uppercased. See read_flat.
+ * 
+ * \param filename   Name of the input file.
+ * \param n          Index of the sequence (starting at 0).
+ * \param seq        A pointer to an unitialized 'sequence' object.
+ * \return           1 (TRUE) if the sequence was found.
+ */
+int read_genbank(const char *filename, unsigned int n, sequence *seq)
+{
+    flat_format format;
+    format.info_tag = "DEFINITION";
+    format.seq_tag = "ORIGIN";
+    format.info_col = 12;
+    format.seq_col = 10;
+    format.full_line = 75;
+    return read_flat(filename, n, seq, &format);
+}
+
+/**
+ * \brief Return a random DNA nucleotide.
+ * 
+ * \param rng    A random number generator. 
+ * \return       'A', 'T', 'C', or 'G'.
+ */
+char dna_random_nuc(well1024 *rng)
+{
+    return "ATGC"[(int)(well1024_next_double(rng) * 4)];
+}
+
+/**
+ * \brief Return a random DNA nucleotide with custom probablity.
+ *
+ * Return a random nucleotide with given probabilities (with the probability for
+ * C = 1 - prob(A + T + G)).
+ * 
+ * \param rng      A random number generator.
+ * \param prob_a   Probability of 'A'.
+ * \param prob_t   Probability of 'T'.
+ * \param prob_g   Probability of 'G'.
+ * \return         'A', 'T', 'C', or 'G'.
+ */
+char dna_random_nuc_prob(well1024 *rng, double prob_a, double prob_t, double prob_g)
+{
+    const double r = well1024_next_double(rng);
+    if (r < prob_a)
+    {
+        return 'A';
+    }
+    else if (r < prob_a + prob_t)
+    {
+        return 'T';
+    }
+    else if (r < prob_a + prob_t + prob_g)
+    {
+        return 'G';
+    }
+    else
+    {
+        return 'C';
+    }
+}
+
+/**
+ * \brief Fill a buffer with random nucleotides, 16 per 32-bit random number.
+ *
+ * \param rng         A random number generator.
+ * \param dst         Where to write the nucleotides (no '\0' is added).
+ * \param length      Number of nucleotides.
+ * \param alphabet    The 4 nucleotides.
+ */
+void nuc_random_fill(well1024 *rng, char *dst, size_t length, const char *alphabet)
+{
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16)
+    {
+        unsigned int r = well1024_next_uint32(rng);
+        int k = 0;
+        for (; k < 16; ++k, r >>= 2)
+        {
+            dst[i + k] = alphabet[r & 3];
+        }
+    }
+    if (i < length)
+    {
+        unsigned int r = well1024_next_uint32(rng);
+        for (; i < length; ++i, r >>= 2)
+        {
+            dst[i] = alphabet[r & 3];
+        }
+    }
+}
+
+/**
+ * \brief Alias table (Vose's method) to draw nucleotides with given probabilities.
+ *
+ * A draw takes a single 32-bit random number: the 2 high bits choose a column
+ * and the 30 low bits choose between the column and its alias.
+ */
+typedef struct
+{
+    unsigned int threshold[4]; /**< Keep the column if the 30 low bits are below. */
+
+    unsigned char alias[4]; /**< The other nucleotide of each column. */
+}
+nuc_alias;
+
+/**
+ * \brief Build an alias table for 'A', 'C', 'G' and 'T' (or 'U').
+ *
+ * \param alias     A pointer to an unitialized 'nuc_alias' object.
+ * \param prob_a    Probability of 'A'.
+ * \param prob_c    Probability of 'C'.
+ * \param prob_g    Probability of 'G'.
+ * \param prob_t    Probability of 'T' (or 'U').
+ */
+void nuc_alias_init(nuc_alias *alias, double prob_a, double prob_c, double prob_g, double prob_t)
+{
+    const double total = prob_a + prob_c + prob_g + prob_t;
+    assert(prob_a >= 0.0 && prob_c >= 0.0 && prob_g >= 0.0 && prob_t >= 0.0 && total > 0.0);
+    double p[4];
+    p[0] = 4.0 * prob_a / total;
+    p[1] = 4.0 * prob_c / total;
+    p[2] = 4.0 * prob_g / total;
+    p[3] = 4.0 * prob_t / total;
+    int small[4], large[4];
+    int nsmall = 0, nlarge = 0;
+    int i = 0;
+    for (; i < 4; ++i)
+    {
+        alias->alias[i] = (unsigned char)i;
+        if (p[i] < 1.0)
+        {
+            small[nsmall++] = i;
+        }
+        else
+        {
+            large[nlarge++] = i;
+        }
+    }
+    while (nsmall > 0 && nlarge > 0)
+    {
+        const int s = small[--nsmall];
+        const int l = large[--nlarge];
+        alias->threshold[s] = (unsigned int)(p[s] * 1073741824.0);
+        alias->alias[s] = (unsigned char)l;
+        p[l] += p[s] - 1.0;
+        if (p[l] < 1.0)
+        {
+            small[nsmall++] = l;
+        }
+        else
+        {
+            large[nlarge++] = l;
+        }
+    }
+    /* What is left has probability 1 (up to rounding errors). */
+    while (nsmall > 0)
+    {
+        alias->threshold[small[--nsmall]] = 1073741824U;
+    }
+    while (nlarge > 0)
+    {
+        alias->threshold[large[--nlarge]] = 1073741824U;
+    }
+}
+
+/**
+ * \brief Draw a nucleotide (0 to 3 for 'A', 'C', 'G', 'T') from an alias table.
+ *
+ * \param rng      A random number generator.
+ * \param alias    The alias table.
+ * \return         The code of the nucleotide.
+ */
+unsigned int nuc_alias_next(well1024 *rng, const nuc_alias *alias)
+{
+    const unsigned int r = well1024_next_uint32(rng);
+    const unsigned int column = r >> 30;
+    return ((r & 0x3fffffffU) < alias->threshold[column]) ? column : alias->alias[column];
+}
+
+/**
+ * \brief Fill a buffer with random nucleotides drawn from an alias table.
+ *
+ * \param rng         A random number generator.
+ * \param alias       The alias table.
+ * \param dst         Where to write the nucleotides (no '\0' is added).
+ * \param length      Number of nucleotides.
+ * \param alphabet    The 4 nucleotides (in the order of the alias table).
+ */
+void nuc_alias_fill(well1024 *rng, const nuc_alias *alias, char *dst, size_t length, const char *alphabet)
+{
+    size_t i = 0;
+    for (; i < length; ++i)
+    {
+        dst[i] = alphabet[nuc_alias_next(rng, alias)];
+    }
+}
+
+/**
+ * \brief Random compressed DNA sequence, the random bits are written directly in the bitfield.
+ *
+ * \param rng       A random number generator.
+ * \param cs        A pointer to an unitialized 'cseq' object.
+ * \param length    Length of the sequence.
+ */
+void cseq_random(well1024 *rng, cseq *cs, unsigned int length)
+{
+    cseq_init(cs, length);
+    cs->length = length;
+    const unsigned int nwords = (length + CSEQ_WORD - 1) / CSEQ_WORD;
+    unsigned int i = 0;
+    for (; i < nwords; ++i)
+    {
+        const uint64_t lo = well1024_next_uint32(rng);
+        const uint64_t hi = well1024_next_uint32(rng);
+        cs->seq[i] = lo | (hi << 32);
+    }
+    /* Bits past the end of the sequence must be 0. */
+    if (length % CSEQ_WORD != 0)
+    {
+        cs->seq[nwords - 1] &= ((uint64_t)1 << (2 * (length % CSEQ_WORD))) - 1;
+    }
+}
+
+/**
+ * \brief Random compressed DNA sequence with nucleotides drawn from an alias table.
+ *
+ * \param rng       A random number generator.
+ * \param alias     The alias table.
+ * \param cs        A pointer to an unitialized 'cseq' object.
+ * \param length    Length of the sequence.
+ */
+void cseq_random_alias(well1024 *rng, const nuc_alias *alias, cseq *cs, unsigned int length)
+{
+    cseq_init(cs, length);
+    cs->length = length;
+    unsigned int i = 0;
+    for (; i < length; ++i)
+    {
+        cs->seq[i / CSEQ_WORD] |= (uint64_t)nuc_alias_next(rng, alias) << (2 * (i % CSEQ_WORD));
+    }
+}
+
+/**
+ * \brief Return a random DNA sequence.
+ * 
+ * One random number per nucleotide, as in previous versions, so seeded runs
+ * are reproduced (nuc_random_fill is faster but draws a different sequence).
+ *
+ * \param rng        A random number generator.
+ * \param seq_size   The length of the resulting sequence.
+ * \return           A sequence of 'A', 'T', 'C', or 'G'.
+ */
+char *dna_random_nuc_seq(well1024 *rng, unsigned int seq_size)
+{
+    assert(seq_size > 0);
+    char *dna_seq = (char*)malloc(seq_size + 1);
+    unsigned int i = 0;
+    for (; i < seq_size; ++i)
+    {
+        dna_seq[i] = "ATGC"[well1024_next_uint32(rng) >> 30];
+    }
+    dna_seq[seq_size] = '\0';
+    return dna_seq;
+}
+
+/**
+ * \brief Return a random RNA nucleotide.
+ * 
+ * \param rng    A random number generator. 
+ * \return       'A', 'U', 'C', or 'G'.
+ */
+char rna_random_nuc(well1024 *rng)
+{
+    return "AUGC"[(int)(well1024_next_double(rng) * 4)];
+}
+
+/**
+ * \brief Return a random RNA nucleotide with custom probablity.
+ *
+ * Return a random nucleotide with given probabilities (with the probability for
+ * C = 1 - prob(A + U + G)).
+ *
+ * \param rng      A random number generator.
+ * \param prob_a   Probability of 'A'.
+ * \param prob_t   Probability of 'U'.
+ * \param prob_g   Probability of 'G'.
+ * \return         'A', 'U', 'C', or 'G'.
+ */
+char rna_random_nuc_prob(well1024 *rng, double prob_a, double prob_u, double prob_g)
+{
+    const double r = well1024_next_double(rng);
+    if (r < prob_a)
+    {
+        return 'A';
+    }
+    else if (r < prob_a + prob_u)
+    {
+        return 'U';
+    }
+    else if (r < prob_a + prob_u + prob_g)
+    {
+        return 'G';
+    }
+    else
+    {
+        return 'C';
+    }
+}
+
+/**
+ * \brief Return a random RNA sequence.
+ * 
+ * One random number per nucleotide, as in previous versions, so seeded runs
+ * are reproduced (nuc_random_fill is faster but draws a different sequence).
+ *
+ * \param rng        A random number generator.
+ * \param seq_size   The length of the resulting sequence.
+ * \return           A sequence of 'A', 'U', 'C', or 'G'.
+ */
+char* rna_random_nuc_seq(well1024 *rng, unsigned int seq_size)
+{
+    assert(seq_size > 0);
+    char *rna_seq = (char*)malloc(seq_size + 1);
+    unsigned int i = 0;
+    for (; i < seq_size; ++i)
+    {
+        rna_seq[i] = "AUGC"[well1024_next_uint32(rng) >> 30];
+    }
+    rna_seq[seq_size] = '\0';
+    return rna_seq;
+}
+
+/**
+ * \brief Return a random DNA sequence with custom probabilities.
+ *
+ * Same probabilities as dna_random_nuc_prob, but drawn from an alias table.
+ * 
+ * \param rng        A random number generator.
+ * \param seq_size   The length of the resulting sequence.
+ * \param prob_a     Probability of 'A'.
+ * \param prob_t     Probability of 'T'.
+ * \param prob_g     Probability of 'G'.
+ * \return           A sequence of 'A', 'T', 'C', or 'G'.
+ */
+char *dna_random_nuc_seq_prob(well1024 *rng, unsigned int seq_size, double prob_a, double prob_t, double prob_g)
+{
+    assert(seq_size > 0);
+    nuc_alias alias;
+    const double prob_c = 1.0 - prob_a - prob_t - prob_g;
+    nuc_alias_init(&alias, prob_a, (prob_c > 0.0) ? prob_c : 0.0, prob_g, prob_t);
+    char *dna_seq = (char*)malloc(seq_size + 1);
+    nuc_alias_fill(rng, &alias, dna_seq, seq_size, "ACGT");
+    dna_seq[seq_size] = '\0';
+    return dna_seq;
+}
+
+/**
+ * \brief Return a random RNA sequence with custom probabilities.
+ *
+ * Same probabilities as rna_random_nuc_prob, but drawn from an alias table.
+ * 
+ * \param rng        A random number generator.
+ * \param seq_size   The length of the resulting sequence.
+ * \param prob_a     Probability of 'A'.
+ * \param prob_u     Probability of 'U'.
+ * \param prob_g     Probability of 'G'.
+ * \return           A sequence of 'A', 'U', 'C', or 'G'.
+ */
+char *rna_random_nuc_seq_prob(well1024 *rng, unsigned int seq_size, double prob_a, double prob_u, double prob_g)
+{
+    assert(seq_size > 0);
+    nuc_alias alias;
+    const double prob_c = 1.0 - prob_a - prob_u - prob_g;
+    nuc_alias_init(&alias, prob_a, (prob_c > 0.0) ? prob_c : 0.0, prob_g, prob_u);
+    char *rna_seq = (char*)malloc(seq_size + 1);
+    nuc_alias_fill(rng, &alias, rna_seq, seq_size, "ACGU");
+    rna_seq[seq_size] = '\0';
+    return rna_seq;
+}
+
+/**
+ * \brief Number of each residue in a sequence.
+ *
+ * Only uppercase residues are counted as nucleotides, lowercase residues are
+ * counted in 'other'.
+ */
+typedef struct
+{
+    uint64_t a; /**< Number of adenosine 'A'. */
+
+    uint64_t c; /**< Number of cytosine 'C'. */
+
+    uint64_t g; /**< Number of guanine 'G'. */
+
+    uint64_t t; /**< Number of thymidine 'T'. */
+
+    uint64_t u; /**< Number of uracil 'U'. */
+
+    uint64_t n; /**< Number of unknown nucleotides 'N'. */
+
+    uint64_t other; /**< Number of other residues. */
+}
+composition;
+
+/**
+ * \brief Count all residues of a sequence of known length in a single pass.
+ *
+ * With SSE2 or AVX2, 16 or 32 residues are compared at once and the counts are
+ * kept in 8-bit lanes, which are added to the totals every 255 blocks.
+ *
+ * \param seq       A sequence.
+ * \param length    Length of the sequence.
+ * \param comp      Set to the number of each residue.
+ */
+void seq_composition_n(const char *seq, size_t length, composition *comp)
+{
+    static const char bases[6] = {'A', 'C', 'G', 'T', 'U', 'N'};
+    uint64_t counts[6] = {0, 0, 0, 0, 0, 0};
+    size_t i = 0;
+    int k;
+#if defined(__AVX2__)
+    while (i + 32 <= length)
+    {
+        size_t blocks = (length - i) / 32;
+        blocks = (blocks > 255) ? 255 : blocks;
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i acc[6];
+        for (k = 0; k < 6; ++k)
+        {
+            acc[k] = zero;
+        }
+        for (; blocks > 0; --blocks, i += 32)
+        {
+            const __m256i v = _mm256_loadu_si256((const __m256i*)(seq + i));
+            for (k = 0; k < 6; ++k)
+            {
+                acc[k] = _mm256_sub_epi8(acc[k], _mm256_cmpeq_epi8(v, _mm256_set1_epi8(bases[k])));
+            }
+        }
+        for (k = 0; k < 6; ++k)
+        {
+            uint64_t sums[4];
+            _mm256_storeu_si256((__m256i*)sums, _mm256_sad_epu8(acc[k], zero));
+            counts[k] += sums[0] + sums[1] + sums[2] + sums[3];
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    while (i + 16 <= length)
+    {
+        size_t blocks = (length - i) / 16;
+        blocks = (blocks > 255) ? 255 : blocks;
+        const __m128i zero = _mm_setzero_si128();
+        __m128i acc[6];
+        for (k = 0; k < 6; ++k)
+        {
+            acc[k] = zero;
+        }
+        for (; blocks > 0; --blocks, i += 16)
+        {
+            const __m128i v = _mm_loadu_si128((const __m128i*)(seq + i));
+            for (k = 0; k < 6; ++k)
+            {
+                acc[k] = _mm_sub_epi8(acc[k], _mm_cmpeq_epi8(v, _mm_set1_epi8(bases[k])));
+            }
+        }
+        for (k = 0; k < 6; ++k)
+        {
+            uint64_t sums[2];
+            _mm_storeu_si128((__m128i*)sums, _mm_sad_epu8(acc[k], zero));
+            counts[k] += sums[0] + sums[1];
+        }
+    }
+#endif
+    for (; i < length; ++i)
+    {
+        for (k = 0; k < 6; ++k)
+        {
+            counts[k] += (seq[i] == bases[k]);
+        }
+    }
+    comp->a = counts[0];
+    comp->c = counts[1];
+    comp->g = counts[2];
+    comp->t = counts[3];
+    comp->u = counts[4];
+    comp->n = counts[5];
+    comp->other = length - counts[0] - counts[1] - counts[2] - counts[3] - counts[4] - counts[5];
+}
+
+/**
+ * \brief Count all residues of a sequence in a single pass.
+ *
+ * \param seq     A sequence.
+ * \param comp    Set to the number of each residue.
+ */
+void seq_composition(const char *seq, composition *comp)
+{
+    seq_composition_n(seq, strlen(seq), comp);
+}
+
+/**
+ * \brief Count the occurences of a char in a sequence of known length.
+ *
+ * \param seq       A sequence.
+ * \param length    Length of the sequence.
+ * \param c         The char to count.
+ * \return          The number of occurence.
+ */
+uint64_t seq_count_n(const char *seq, size_t length, const char c)
+{
+    uint64_t count = 0;
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i c32 = _mm256_set1_epi8(c);
+    while (i + 32 <= length)
+    {
+        size_t blocks = (length - i) / 32;
+        blocks = (blocks > 255) ? 255 : blocks;
+        __m256i acc = _mm256_setzero_si256();
+        for (; blocks > 0; --blocks, i += 32)
+        {
+            const __m256i v = _mm256_loadu_si256((const __m256i*)(seq + i));
+            acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(v, c32));
+        }
+        uint64_t sums[4];
+        _mm256_storeu_si256((__m256i*)sums, _mm256_sad_epu8(acc, _mm256_setzero_si256()));
+        count += sums[0] + sums[1] + sums[2] + sums[3];
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i c16 = _mm_set1_epi8(c);
+    while (i + 16 <= length)
+    {
+        size_t blocks = (length - i) / 16;
+        blocks = (blocks > 255) ? 255 : blocks;
+        __m128i acc = _mm_setzero_si128();
+        for (; blocks > 0; --blocks, i += 16)
+        {
+            const __m128i v = _mm_loadu_si128((const __m128i*)(seq + i));
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(v, c16));
+        }
+        uint64_t sums[2];
+        _mm_storeu_si128((__m128i*)sums, _mm_sad_epu8(acc, _mm_setzero_si128()));
+        count += sums[0] + sums[1];
+    }
+#endif
+    for (; i < length; ++i)
+    {
+        count += (seq[i] == c);
+    }
+    return count;
+}
+
+/**
+ * \brief Count the occurences of a char in a string.
+ * 
+ * \param seq    A sequence. 
+ * \return       The number of occurence.
+ */
+unsigned int seq_count(const char *seq, const char c)
+{
+    return (unsigned int)seq_count_n(seq, strlen(seq), c);
+}
+
+/**
+ * \brief Count the number of adenosine 'A' in the sequence.
+ * 
+ * \param seq    A sequence. 
+ * \return       The number of adenosine 'A'.
+ */
+unsigned int a_count(const char *seq)
+{
+    return seq_count(seq, 'A');
+}
+
+/**
+ * \brief Count the number of thymidine 'T' in the sequence.
+ * 
+ * \param seq    A sequence. 
+ * \return       The number of thymidine 'T'.
+ */
+unsigned int t_count(const char *seq)
+{
+    return seq_count(seq, 'T');
+}
+
+/**
+ * \brief Count the number of uracil 'U' in the sequence.
+ * 
+ * \param seq    A sequence. 
+ * \return       The number of uracil 'U'.
+ */
+unsigned int u_count(const char *seq)
+{
+    return seq_count(seq, 'U');
+}
+
+/**
+ * \brief Count the number of guanine 'G' in the sequence.
+ * 
+ * \param seq    A sequence. 
+ * \return       The number of guanine 'G'.
+ */
+unsigned int g_count(const char *seq)
+{
+    return seq_count(seq, 'G');
+}
+
+/**
+ * \brief Count the number of cytosine 'C' in the sequence.
+ * 
+ * \param seq    A sequence. 
+ * \return       The number of cytosine 'C'.
+ */
+unsigned int c_count(const char *seq)
+{
+    return seq_count(seq, 'C');
+}
+
+/**
+ * \brief Count the number of cytosine 'C' and guanine 'G' in the sequence.
+ * 
+ * \param seq    A sequence. 
+ * \return       The number of cytosine 'C' and guanine 'G'.
+ */
+unsigned int gc_count(const char *seq)
+{
+    composition comp;
+    seq_composition(seq, &comp);
+    return (unsigned int)(comp.g + comp.c);
+}
+
+/**
+ * \brief Return GC content (number of 'G' + number of 'C') / size.
+ * 
+ * \param seq    A sequence. 
+ * \return       The proportion of cytosine 'C' and guanine 'G'.
+ */
+double gc_content(const char *seq)
+{
+    const size_t length = strlen(seq);
+    composition comp;
+    seq_composition_n(seq, length, &comp);
+    return (double)(comp.g + comp.c) / length;
+}
+
+/**
+ * \brief GC content of a composition ('G' + 'C' over all residues).
+ *
+ * \param comp    The composition.
+ * \return        The proportion of cytosine 'C' and guanine 'G'.
+ */
+double composition_gc_content(const composition *comp)
+{
+    const uint64_t total = comp->a + comp->c + comp->g + comp->t + comp->u + comp->n + comp->other;
+    return (double)(comp->g + comp->c) / total;
+}
+
+/**
+ * \brief Index of a residue in a window count: A, C, G, T, U, N and other.
+ */
+static const unsigned char window_index[256] =
+{
+    6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6, 6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,
+    6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6, 6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,
+    6,0,6,1,6,6,6,2,6,6,6,6,6,6,5,6, 6,6,6,6,3,4,6,6,6,6,6,6,6,6,6,6,
+    6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6, 6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,
+    6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6, 6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,
+    6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6, 6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,
+    6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6, 6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,
+    6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6, 6,6,6,6,6,6,6,6,6,6,6,6,6,6,6,6
+};
+
+/**
+ * \brief Called for each window with its first position and its composition.
+ */
+typedef void (*window_callback)(uint64_t start, const composition *comp, void *data);
+
+/**
+ * \brief Sliding-window composition profiler for sequences read in chunks.
+ *
+ * The counts are updated incrementally (one residue added and one removed per
+ * position) and the last 'window' residues are kept in a ring buffer, so chunks
+ * can be of any size and windows can span chunks.
+ */
+typedef struct
+{
+    unsigned int window; /**< Size of the windows. */
+
+    unsigned int step; /**< Distance between the start of two windows. */
+
+    char *ring; /**< The last 'window' residues. */
+
+    uint64_t pos; /**< Number of residues fed so far. */
+
+    uint64_t counts[7]; /**< Counts of the current window (see window_index). */
+
+    window_callback callback; /**< Called for each window. */
+
+    void *data; /**< Passed to the callback. */
+}
+window_profile;
+
+/**
+ * \brief Copy window counts to a composition.
+ */
+void window_composition(const uint64_t counts[7], composition *comp)
+{
+    comp->a = counts[0];
+    comp->c = counts[1];
+    comp->g = counts[2];
+    comp->t = counts[3];
+    comp->u = counts[4];
+    comp->n = counts[5];
+    comp->other = counts[6];
+}
+
+/**
+ * \brief Initialize a sliding-window profiler.
+ *
+ * \param wp          A pointer to an unitialized 'window_profile' object.
+ * \param window      Size of the windows (> 0).
+ * \param step        Distance between the start of two windows (> 0).
+ * \param callback    Called for each complete window.
+ * \param data        Passed to the callback.
+ */
+void window_profile_init(window_profile *wp, unsigned int window, unsigned int step,
+                         window_callback callback, void *data)
+{
+    assert(window > 0 && step > 0);
+    wp->window = window;
+    wp->step = step;
+    wp->ring = (char*)malloc(window);
+    wp->pos = 0;
+    memset(wp->counts, 0, sizeof(wp->counts));
+    wp->callback = callback;
+    wp->data = data;
+}
+
+/**
+ * \brief Free the memory used by a sliding-window profiler.
+ *
+ * \param wp    The profiler.
+ */
+void window_profile_free(window_profile *wp)
+{
+    free(wp->ring);
+    wp->ring = NULL;
+}
+
+/**
+ * \brief Feed the next chunk of the sequence to a sliding-window profiler.
+ *
+ * \param wp        The profiler.
+ * \param seq       The chunk.
+ * \param length    Length of the chunk.
+ */
+void window_profile_feed(window_profile *wp, const char *seq, size_t length)
+{
+    const unsigned int window = wp->window;
+    composition comp;
+    size_t i = 0;
+    for (; i < length; ++i)
+    {
+        const unsigned int slot = (unsigned int)(wp->pos % window);
+        if (wp->pos >= window)
+        {
+            --wp->counts[window_index[(unsigned char)wp->ring[slot]]];
+        }
+        wp->ring[slot] = seq[i];
+        ++wp->counts[window_index[(unsigned char)seq[i]]];
+        ++wp->pos;
+        if (wp->pos >= window && (wp->pos - window) % wp->step == 0)
+        {
+            window_composition(wp->counts, &comp);
+            wp->callback(wp->pos - window, &comp, wp->data);
+        }
+    }
+}
+
+/**
+ * \brief Composition of all windows of a sequence.
+ *
+ * Windows start at 0, step, 2 * step, ... and only complete windows are
+ * reported. Each position is added and removed once: \f$O(n)\f$ whatever the
+ * size of the windows.
+ *
+ * \param seq         A sequence.
+ * \param length      Length of the sequence.
+ * \param window      Size of the windows (> 0).
+ * \param step        Distance between the start of two windows (> 0).
+ * \param callback    Called for each window.
+ * \param data        Passed to the callback.
+ * \return            The number of windows.
+ */
+uint64_t seq_window_profile(const char *seq, size_t length, unsigned int window, unsigned int step,
+                            window_callback callback, void *data)
+{
+    assert(window > 0 && step > 0);
+    uint64_t counts[7] = {0, 0, 0, 0, 0, 0, 0};
+    uint64_t nwindows = 0;
+    composition comp;
+    size_t i = 0;
+    for (; i < length; ++i)
+    {
+        if (i >= window)
+        {
+            --counts[window_index[(unsigned char)seq[i - window]]];
+        }
+        ++counts[window_index[(unsigned char)seq[i]]];
+        if (i + 1 >= window && (i + 1 - window) % step == 0)
+        {
+            window_composition(counts, &comp);
+            callback(i + 1 - window, &comp, data);
+            ++nwindows;
+        }
+    }
+    return nwindows;
+}
+
+/**
+ * \brief Return the composition of all windows of a sequence in an array.
+ *
+ * \param seq         A sequence.
+ * \param length      Length of the sequence.
+ * \param window      Size of the windows (> 0).
+ * \param step        Distance between the start of two windows (> 0).
+ * \param nwindows    Set to the number of windows.
+ * \return            The compositions, window i starts at i * step (to free with free).
+ */
+composition *seq_windows(const char *seq, size_t length, unsigned int window, unsigned int step,
+                         uint64_t *nwindows)
+{
+    *nwindows = (length >= window) ? (length - window) / step + 1 : 0;
+    composition *windows = (composition*)malloc((*nwindows > 0 ? *nwindows : 1) * sizeof(composition));
+    uint64_t counts[7] = {0, 0, 0, 0, 0, 0, 0};
+    uint64_t w = 0;
+    size_t i = 0;
+    for (; i < length; ++i)
+    {
+        if (i >= window)
+        {
+            --counts[window_index[(unsigned char)seq[i - window]]];
+        }
+        ++counts[window_index[(unsigned char)seq[i]]];
+        if (i + 1 >= window && (i + 1 - window) % step == 0)
+        {
+            window_composition(counts, &windows[w++]);
+        }
+    }
+    return windows;
+}
+
+#if defined(__SSE2__)
+/**
+ * \brief Bit i is set if residue i of the vector is 'A', 'C', 'G' or 'last'.
+ */
+int nuc_mask_16(__m128i v, __m128i last)
+{
+    const __m128i ok = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('A')),
+                                                 _mm_cmpeq_epi8(v, _mm_set1_epi8('C'))),
+                                    _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('G')),
+                                                 _mm_cmpeq_epi8(v, last)));
+    return _mm_movemask_epi8(ok);
+}
+#endif
+
+/**
+ * \brief Find the first residue that is not 'A', 'C', 'G' or 'last'.
+ *
+ * With SSE2, 16 residues are checked at once. If 'histogram' is given, the
+ * whole sequence is read and the invalid residues are counted (only the blocks
+ * with an invalid residue are counted one residue at a time).
+ *
+ * \param seq          A sequence.
+ * \param length       Length of the sequence.
+ * \param last         The fourth nucleotide ('T' or 'U').
+ * \param histogram    If not NULL, the number of occurences of each invalid residue is added.
+ * \return             Position of the first invalid residue, length if there is none.
+ */
+size_t nuc_validate_n(const char *seq, size_t length, char last, uint64_t histogram[256])
+{
+    size_t first = length;
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i last16 = _mm_set1_epi8(last);
+    for (; i + 16 <= length; i += 16)
+    {
+        const int mask = nuc_mask_16(_mm_loadu_si128((const __m128i*)(seq + i)), last16);
+        if (mask != 0xffff)
+        {
+            if (first == length)
+            {
+                int k = 0;
+                while (mask & (1 << k))
+                {
+                    ++k;
                 }
-                else
+                first = i + k;
+            }
+            if (histogram == NULL)
+            {
+                return first;
+            }
+            int k = 0;
+            for (; k < 16; ++k)
+            {
+                if (!(mask & (1 << k)))
                 {
-                    amino_seq[a] = 'Q';
+                    ++histogram[(unsigned char)seq[i + k]];
                 }
             }
-            else
+        }
+    }
+#endif
+    for (; i < length; ++i)
+    {
+        const char c = seq[i];
+        if (!(c == 'A' || c == 'C' || c == 'G' || c == last))
+        {
+            if (first == length)
+            {
+                first = i;
+            }
+            if (histogram == NULL)
             {
-                amino_seq[a] = 'R';
+                return first;
             }
+            ++histogram[(unsigned char)c];
+        }
+    }
+    return first;
+}
+
+/**
+ * \brief Find the first residue of a DNA sequence that is not 'A', 'C', 'G' or 'T'.
+ *
+ * \param dna_seq      A DNA sequence.
+ * \param length       Length of the sequence.
+ * \param histogram    If not NULL, the number of occurences of each invalid residue is added.
+ * \return             Position of the first invalid residue, length if there is none.
+ */
+size_t dna_validate_n(const char *dna_seq, size_t length, uint64_t histogram[256])
+{
+    return nuc_validate_n(dna_seq, length, 'T', histogram);
+}
+
+/**
+ * \brief Find the first residue of a RNA sequence that is not 'A', 'C', 'G' or 'U'.
+ *
+ * \param rna_seq      A RNA sequence.
+ * \param length       Length of the sequence.
+ * \param histogram    If not NULL, the number of occurences of each invalid residue is added.
+ * \return             Position of the first invalid residue, length if there is none.
+ */
+size_t rna_validate_n(const char *rna_seq, size_t length, uint64_t histogram[256])
+{
+    return nuc_validate_n(rna_seq, length, 'U', histogram);
+}
+
+/**
+ * \brief Return TRUE if the sequence is only made of 'G', 'C', 'T' or 'A'.
+ * 
+ * \param dna_seq    A DNA sequence. 
+ * \return           1 (TRUE) if the sequence is made of 'G', 'C', 'T' or 'A'.
+ */
+int dna_pure_seq(const char *dna_seq)
+{
+    const size_t length = strlen(dna_seq);
+    return dna_validate_n(dna_seq, length, NULL) == length;
+}
+
+/**
+ * \brief Return TRUE if the sequence is only made of 'G', 'C', 'U' or 'A'.
+ * 
+ * \param rna_seq    A RNA sequence. 
+ * \return           1 (TRUE) if the sequence is made of 'G', 'C', 'U' or 'A'.
+ */
+int rna_pure_seq(const char *rna_seq)
+{
+    const size_t length = strlen(rna_seq);
+    return rna_validate_n(rna_seq, length, NULL) == length;
+}
+
+/**
+ * \brief Keep only the 'A', 'C', 'G' and 'last' of a sequence.
+ *
+ * With SSSE3, each block of 16 residues is validated at once and, unless it is
+ * all valid (then it is copied as is), packed to the left with compact_16.
+ *
+ * \param seq       A sequence.
+ * \param length    Length of the sequence.
+ * \param last      The fourth nucleotide ('T' or 'U').
+ * \param dst       Where to write the residues kept, with room for 'length'
+ *                  bytes: the bytes after the ones kept are overwritten too
+ *                  (can be seq, no '\0' is added).
+ * \return          The number of residues kept.
+ */
+size_t nuc_compact_n(const char *seq, size_t length, char last, char *dst)
+{
+    size_t count = 0;
+    size_t i = 0;
+#if defined(__SSSE3__)
+    const __m128i last16 = _mm_set1_epi8(last);
+    /* Writes never go past i + 16, so dst can be seq. */
+    for (; i + 16 <= length; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(seq + i));
+        const int mask = nuc_mask_16(v, last16);
+        if (mask == 0xffff)
+        {
+            _mm_storeu_si128((__m128i*)(dst + count), v);
+            count += 16;
+            continue;
+        }
+        count += compact_16(v, mask, dst + count);
+    }
+#endif
+    for (; i < length; ++i)
+    {
+        const char c = seq[i];
+        dst[count] = c;
+        count += (c == 'A' || c == 'C' || c == 'G' || c == last);
+    }
+    return count;
+}
+
+/**
+ * \brief Keep only the 'A', 'C', 'G' and 'T' of a DNA sequence.
+ *
+ * \param dna_seq    A DNA sequence.
+ * \param length     Length of the sequence.
+ * \param dst        Where to write the nucleotides kept, with room for 'length'
+ *                   bytes (can be dna_seq, no '\0' is added, see nuc_compact_n).
+ * \return           The number of nucleotides kept.
+ */
+size_t dna_compact_n(const char *dna_seq, size_t length, char *dst)
+{
+    return nuc_compact_n(dna_seq, length, 'T', dst);
+}
+
+/**
+ * \brief Keep only the 'A', 'C', 'G' and 'U' of a RNA sequence.
+ *
+ * \param rna_seq    A RNA sequence.
+ * \param length     Length of the sequence.
+ * \param dst        Where to write the nucleotides kept, with room for 'length'
+ *                   bytes (can be rna_seq, no '\0' is added, see nuc_compact_n).
+ * \return           The number of nucleotides kept.
+ */
+size_t rna_compact_n(const char *rna_seq, size_t length, char *dst)
+{
+    return nuc_compact_n(rna_seq, length, 'U', dst);
+}
+
+/**
+ * \brief Return a sequence with everything removed except 'G', 'C', 'T' and 'A'.
+ * 
+ * \param dna_seq    A DNA sequence. 
+ * \return           A DNA sequence without the ambiguities.
+ */
+char *dna_rmv_amb(char *dna_seq)
+{
+    const size_t length = strlen(dna_seq);
+    char *new_dna_seq = (char*)malloc(length + 1);
+    const size_t count = dna_compact_n(dna_seq, length, new_dna_seq);
+    new_dna_seq[count] = '\0';
+    return new_dna_seq;
+}
+
+/**
+ * \brief Return a sequence with everything removed except 'G', 'C', 'U' and 'A'.
+ * 
+ * \param rna_seq    A RNA sequence. 
+ * \return           A RNA sequence without the ambiguities.
+ */
+char *rna_rmv_amb(char *rna_seq)
+{
+    const size_t length = strlen(rna_seq);
+    char *new_rna_seq = (char*)malloc(length + 1);
+    const size_t count = rna_compact_n(rna_seq, length, new_rna_seq);
+    new_rna_seq[count] = '\0';
+    return new_rna_seq;
+}
+
+#if defined(__SSSE3__)
+/**
+ * \brief Reverse and complement 16 residues (see iupac_complement).
+ *
+ * Letters are complemented by flipping the bits that differ between a letter
+ * and its complement, the mask being looked up with the low 5 bits.
+ */
+__m128i revcomp_16(__m128i v)
+{
+    const __m128i delta_lo = _mm_setr_epi8(0, 21, 20, 4, 12, 0, 0, 4, 12, 0, 0, 6, 0, 6, 0, 0);
+    const __m128i delta_hi = _mm_setr_epi8(0, 0, 11, 0, 21, 20, 20, 0, 0, 11, 0, 0, 0, 0, 0, 0);
+    const __m128i reverse = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m128i index = _mm_and_si128(v, _mm_set1_epi8(0x0f));
+    const __m128i hi = _mm_cmpeq_epi8(_mm_and_si128(v, _mm_set1_epi8(0x10)), _mm_set1_epi8(0x10));
+    const __m128i letter = _mm_cmpeq_epi8(_mm_and_si128(v, _mm_set1_epi8((char)0xc0)), _mm_set1_epi8(0x40));
+    __m128i delta = _mm_or_si128(_mm_and_si128(hi, _mm_shuffle_epi8(delta_hi, index)),
+                                 _mm_andnot_si128(hi, _mm_shuffle_epi8(delta_lo, index)));
+    delta = _mm_and_si128(delta, letter);
+    return _mm_shuffle_epi8(_mm_xor_si128(v, delta), reverse);
+}
+#endif
+
+/**
+ * \brief Write the reverse complement of a sequence in a buffer.
+ *
+ * IUPAC codes are complemented (see iupac_complement) and the case is kept.
+ * With SSSE3, 16 residues are complemented and reversed with byte shuffles.
+ *
+ * \param seq       A DNA sequence.
+ * \param length    Length of the sequence.
+ * \param dst       Where to write the length residues (no '\0' is added, must not overlap seq).
+ */
+void revcomp_n(const char *seq, size_t length, char *dst)
+{
+    size_t i = 0;
+#if defined(__SSSE3__)
+    for (; i + 16 <= length; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(seq + i));
+        _mm_storeu_si128((__m128i*)(dst + length - i - 16), revcomp_16(v));
+    }
+#endif
+    for (; i < length; ++i)
+    {
+        dst[length - 1 - i] = (char)iupac_complement[(unsigned char)seq[i]];
+    }
+}
+
+/**
+ * \brief Replace a sequence by its reverse complement, without copy.
+ *
+ * \param seq       A DNA sequence.
+ * \param length    Length of the sequence.
+ */
+void revcomp_inplace(char *seq, size_t length)
+{
+    size_t i = 0, j = length;
+#if defined(__SSSE3__)
+    for (; j - i >= 32; i += 16, j -= 16)
+    {
+        const __m128i a = _mm_loadu_si128((const __m128i*)(seq + i));
+        const __m128i b = _mm_loadu_si128((const __m128i*)(seq + j - 16));
+        _mm_storeu_si128((__m128i*)(seq + i), revcomp_16(b));
+        _mm_storeu_si128((__m128i*)(seq + j - 16), revcomp_16(a));
+    }
+#endif
+    for (; j - i >= 2; ++i, --j)
+    {
+        const char c = seq[i];
+        seq[i] = (char)iupac_complement[(unsigned char)seq[j - 1]];
+        seq[j - 1] = (char)iupac_complement[(unsigned char)c];
+    }
+    if (j - i == 1)
+    {
+        seq[i] = (char)iupac_complement[(unsigned char)seq[i]];
+    }
+}
+
+/**
+ * \brief Return the antisense strand of a DNA sequence.
+ * 
+ * \param dna_seq    A DNA sequence (IUPAC codes are complemented). 
+ * \return           The antisense strand.
+ */
+char *dna_antisense(const char *dna_seq)
+{
+    const size_t seq_len = strlen(dna_seq);
+    char *dna_antisense = (char*)malloc(seq_len + 1);
+    revcomp_n(dna_seq, seq_len, dna_antisense);
+    dna_antisense[seq_len] = '\0';
+    return dna_antisense;
+}
+
+/**
+ * \brief DNA -> RNA.
+ *
+ * Start reading when encountering a start codon. Both the DNA sequence and the
+ * resulting RNA sequence are in the 5' -> 3' direction.
+ * 
+ * \param dna_seq    A DNA sequence. 
+ * \return           RNA sequence resulting from transcription.
+ */
+char* transcription(const char* dna_seq)
+{
+    assert(dna_pure_seq(dna_seq));
+    const int seq_len = strlen(dna_seq);
+    char* rna_seq = (char*)malloc(seq_len + 1);
+
+    int i = 0;
+    for (; i < seq_len; ++i)
+    {
+        if (dna_seq[i] == 'T')
+        {
+            rna_seq[i] = 'U';
+        }
+        else
+        {
+            rna_seq[i] = dna_seq[i];
+        }
+    }
+    rna_seq[seq_len] = '\0';
+    return rna_seq;
+}
+
+/**
+ * \brief Code of a nucleotide in a codon index: 0 to 3 for 'A', 'C', 'G', 'T' or 'U' (any case), 4 for the others.
+ */
+static const unsigned char codon_code[256] =
+{
+    4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4, 4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,
+    4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4, 4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,
+    4,0,4,1,4,4,4,2,4,4,4,4,4,4,4,4, 4,4,4,4,3,3,4,4,4,4,4,4,4,4,4,4,
+    4,0,4,1,4,4,4,2,4,4,4,4,4,4,4,4, 4,4,4,4,3,3,4,4,4,4,4,4,4,4,4,4,
+    4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4, 4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,
+    4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4, 4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,
+    4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4, 4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,
+    4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4, 4,4,4,4,4,4,4,4,4,4,4,4,4,4,4,4
+};
+
+/**
+ * \brief The default genetic code, indexed by 16 * first + 4 * second + third nucleotide (see codon_code).
+ *
+ * The standard code, or the GCODE_ macros if CUSTOMCODE is defined. Stop codons are 'Z'.
+ */
+static const char translation_table[64] =
+{
+#ifdef CUSTOMCODE
+    GCODE_AAA, GCODE_AAC, GCODE_AAG, GCODE_AAU,
+    GCODE_ACA, GCODE_ACC, GCODE_ACG, GCODE_ACU,
+    GCODE_AGA, GCODE_AGC, GCODE_AGG, GCODE_AGU,
+    GCODE_AUA, GCODE_AUC, GCODE_AUG, GCODE_AUU,
+    GCODE_CAA, GCODE_CAC, GCODE_CAG, GCODE_CAU,
+    GCODE_CCA, GCODE_CCC, GCODE_CCG, GCODE_CCU,
+    GCODE_CGA, GCODE_CGC, GCODE_CGG, GCODE_CGU,
+    GCODE_CUA, GCODE_CUC, GCODE_CUG, GCODE_CUU,
+    GCODE_GAA, GCODE_GAC, GCODE_GAG, GCODE_GAU,
+    GCODE_GCA, GCODE_GCC, GCODE_GCG, GCODE_GCU,
+    GCODE_GGA, GCODE_GGC, GCODE_GGG, GCODE_GGU,
+    GCODE_GUA, GCODE_GUC, GCODE_GUG, GCODE_GUU,
+    GCODE_UAA, GCODE_UAC, GCODE_UAG, GCODE_UAU,
+    GCODE_UCA, GCODE_UCC, GCODE_UCG, GCODE_UCU,
+    GCODE_UGA, GCODE_UGC, GCODE_UGG, GCODE_UGU,
+    GCODE_UUA, GCODE_UUC, GCODE_UUG, GCODE_UUU
+#else
+    'K', 'N', 'K', 'N', 'T', 'T', 'T', 'T', 'R', 'S', 'R', 'S', 'I', 'I', 'M', 'I',
+    'Q', 'H', 'Q', 'H', 'P', 'P', 'P', 'P', 'R', 'R', 'R', 'R', 'L', 'L', 'L', 'L',
+    'E', 'D', 'E', 'D', 'A', 'A', 'A', 'A', 'G', 'G', 'G', 'G', 'V', 'V', 'V', 'V',
+    'Z', 'Y', 'Z', 'Y', 'S', 'S', 'S', 'S', 'Z', 'C', 'W', 'C', 'L', 'F', 'L', 'F'
+#endif
+};
+
+#if defined(__SSSE3__)
+/**
+ * \brief Shuffles gathering the first, second and third nucleotides of 16 codons from 3 vectors.
+ */
+static const signed char translate_shuffle[9][16] =
+{
+    { 0,  3,  6,  9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    { 1,  4,  7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    { 2,  5,  8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+    {-1, -1, -1, -1, -1, -1,  2,  5,  8, 11, 14, -1, -1, -1, -1, -1},
+    {-1, -1, -1, -1, -1,  0,  3,  6,  9, 12, 15, -1, -1, -1, -1, -1},
+    {-1, -1, -1, -1, -1,  1,  4,  7, 10, 13, -1, -1, -1, -1, -1, -1},
+    {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  1,  4,  7, 10, 13},
+    {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  2,  5,  8, 11, 14},
+    {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0,  3,  6,  9, 12, 15}
+};
+#endif
+
+/**
+ * \brief Translate a single codon ('X' if it has an invalid residue).
+ *
+ * \param codon    The 3 nucleotides.
+ * \param table    The genetic code (see translate_n).
+ * \return         The amino acid.
+ */
+char translate_codon(const char *codon, const char *table)
+{
+    const unsigned char n1 = codon_code[(unsigned char)codon[0]];
+    const unsigned char n2 = codon_code[(unsigned char)codon[1]];
+    const unsigned char n3 = codon_code[(unsigned char)codon[2]];
+    return ((n1 | n2 | n3) & 4) ? 'X' : table[16 * n1 + 4 * n2 + n3];
+}
+
+/**
+ * \brief Translate a DNA or RNA sequence of known length with a genetic code.
+ *
+ * Each codon is turned into a 6-bit index in a 64-entry table, so there is no
+ * branch per codon. With SSSE3, 16 codons (48 nucleotides) are translated at
+ * once: the nucleotides are gathered with shuffles and the table is looked up
+ * with 4 shuffles of 16 entries. Codons with something else than 'A', 'C',
+ * 'G', 'T' or 'U' (any case) are translated to 'X'.
+ *
+ * \param seq       A DNA or RNA sequence.
+ * \param length    Length of the sequence (the last length % 3 nucleotides are ignored).
+ * \param table     The genetic code (see translation_table).
+ * \param amino     Where to write the length / 3 amino acids and a '\0'.
+ * \return          The number of amino acids.
+ */
+size_t translate_n(const char *seq, size_t length, const char *table, char *amino)
+{
+    const size_t n_amino = length / 3;
+    size_t a = 0;
+#if defined(__SSSE3__)
+    const __m128i lut0 = _mm_loadu_si128((const __m128i*)table);
+    const __m128i lut1 = _mm_loadu_si128((const __m128i*)(table + 16));
+    const __m128i lut2 = _mm_loadu_si128((const __m128i*)(table + 32));
+    const __m128i lut3 = _mm_loadu_si128((const __m128i*)(table + 48));
+    /* (c >> 1) & 3 is A:0, C:1, T/U:2, G:3 (any case), swap G and T. */
+    const __m128i fix = _mm_setr_epi8(0, 1, 3, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i three = _mm_set1_epi8(3);
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i na = _mm_set1_epi8('a'), nc = _mm_set1_epi8('c'), ng = _mm_set1_epi8('g');
+    const __m128i nt = _mm_set1_epi8('t'), nu = _mm_set1_epi8('u');
+    __m128i shuffle[9];
+    int k;
+    for (k = 0; k < 9; ++k)
+    {
+        shuffle[k] = _mm_loadu_si128((const __m128i*)translate_shuffle[k]);
+    }
+    for (; a + 16 <= n_amino; a += 16)
+    {
+        const char *block = seq + 3 * a;
+        __m128i v[3];
+        int valid = 0xffff;
+        for (k = 0; k < 3; ++k)
+        {
+            v[k] = _mm_loadu_si128((const __m128i*)(block + 16 * k));
+            const __m128i lower = _mm_or_si128(v[k], case_bit);
+            const __m128i ok = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(lower, na), _mm_cmpeq_epi8(lower, nc)),
+                                            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(lower, ng), _mm_cmpeq_epi8(lower, nt)),
+                                                         _mm_cmpeq_epi8(lower, nu)));
+            valid &= _mm_movemask_epi8(ok);
+            v[k] = _mm_shuffle_epi8(fix, _mm_and_si128(_mm_srli_epi16(v[k], 1), three));
         }
-        else if (rna_seq[i] == 'A')
+        if (valid != 0xffff)
         {
-            if (rna_seq[i + 1] == 'U')
-            {
-                if (rna_seq[i + 2] == 'G')
-                {
-                    amino_seq[a] = 'M';
-                }
-                else
-                {
-                    amino_seq[a] = 'I';
-                }
-            }
-            else if (rna_seq[i + 1] == 'C')
-            {
-                amino_seq[a] = 'T';
-            }
-            else if (rna_seq[i + 1] == 'A')
-            {
-                if (rna_seq[i + 2] == 'U' || rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = 'N';
-                }
-                else
-                {
-                    amino_seq[a] = 'K';
-                }
-            }
-            else
+            /* Only this block needs the scalar code. */
+            for (k = 0; k < 16; ++k)
             {
-                if (rna_seq[i + 2] == 'U' || rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = 'S';
-                }
-                else
-                {
-                    amino_seq[a] = 'R';
-                }
+                amino[a + k] = translate_codon(block + 3 * k, table);
             }
+            continue;
         }
-        else
+        __m128i b[3];
+        for (k = 0; k < 3; ++k)
         {
-            if (rna_seq[i + 1] == 'U')
-            {
-                amino_seq[a] = 'V';
-            }
-            else if (rna_seq[i + 1] == 'C')
-            {
-                amino_seq[a] = 'A';
-            }
-            else if (rna_seq[i + 1] == 'A')
-            {
-                if (rna_seq[i + 2] == 'U' || rna_seq[i + 2] == 'C')
-                {
-                    amino_seq[a] = 'D';
-                }
-                else
-                {
-                    amino_seq[a] = 'E';
-                }
-            }
-            else
-            {
-                amino_seq[a] = 'G';
-            }
+            b[k] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v[0], shuffle[k]),
+                                             _mm_shuffle_epi8(v[1], shuffle[3 + k])),
+                                _mm_shuffle_epi8(v[2], shuffle[6 + k]));
         }
+        /* The low 4 bits of the index select the entry, the first nucleotide selects the table. */
+        const __m128i low = _mm_or_si128(_mm_slli_epi16(b[1], 2), b[2]);
+        __m128i r = _mm_and_si128(_mm_shuffle_epi8(lut0, low), _mm_cmpeq_epi8(b[0], _mm_setzero_si128()));
+        r = _mm_or_si128(r, _mm_and_si128(_mm_shuffle_epi8(lut1, low), _mm_cmpeq_epi8(b[0], _mm_set1_epi8(1))));
+        r = _mm_or_si128(r, _mm_and_si128(_mm_shuffle_epi8(lut2, low), _mm_cmpeq_epi8(b[0], _mm_set1_epi8(2))));
+        r = _mm_or_si128(r, _mm_and_si128(_mm_shuffle_epi8(lut3, low), _mm_cmpeq_epi8(b[0], three)));
+        _mm_storeu_si128((__m128i*)(amino + a), r);
+    }
 #endif
-        i += 3;
-        ++a;
+    for (; a < n_amino; ++a)
+    {
+        amino[a] = translate_codon(seq + 3 * a, table);
+    }
+    amino[n_amino] = '\0';
+    return n_amino;
+}
+
+/**
+ * \brief Translate a DNA or RNA sequence of known length to an amino acid sequence.
+ *
+ * \param seq       A DNA or RNA sequence.
+ * \param length    Length of the sequence.
+ * \return          A sequence of amino acids (to free with free).
+ */
+char *translation_n(const char *seq, size_t length)
+{
+    char *amino_seq = (char*)malloc(length / 3 + 1);
+    translate_n(seq, length, translation_table, amino_seq);
+    return amino_seq;
+}
+
+/**
+ * \brief Initialize a genetic code with the default code (see translation_table).
+ *
+ * \param code    A pointer to an unitialized 'genetic_code' object.
+ */
+void genetic_code_default(genetic_code *code)
+{
+    unsigned int i = 0;
+    for (; i < 64; ++i)
+    {
+        code->table[i] = translation_table[i];
+        code->start[i] = (i == 14);
     }
-    amino_seq[n_amino] = '\0';
+#ifdef CUSTOMCODE
+    code->id = 0;
+    code->name = "Custom";
+#else
+    code->id = 1;
+    code->name = ncbi_codes[0].name;
+#endif
+}
+
+/**
+ * \brief Translate a DNA or RNA sequence of known length with a genetic code.
+ *
+ * \param seq       A DNA or RNA sequence.
+ * \param length    Length of the sequence.
+ * \param code      The genetic code.
+ * \return          A sequence of amino acids (to free with free).
+ */
+char *translation_gcode_n(const char *seq, size_t length, const genetic_code *code)
+{
+    char *amino_seq = (char*)malloc(length / 3 + 1);
+    translate_n(seq, length, code->table, amino_seq);
     return amino_seq;
 }
 
+/**
+ * \brief Translate a DNA or RNA sequence with a genetic code.
+ *
+ * \param seq     A DNA or RNA sequence.
+ * \param code    The genetic code.
+ * \return        A sequence of amino acids (to free with free).
+ */
+char *translation_gcode(const char *seq, const genetic_code *code)
+{
+    return translation_gcode_n(seq, strlen(seq), code);
+}
+
+/**
+ * \brief Translate RNA (or DNA) to an amino acid sequence.
+ *
+ * \param dna_seq    A RNA sequence. 
+ * \return           A sequence of amino acids.
+ */
+char *translation(const char *rna_seq)
+{
+    return translation_n(rna_seq, strlen(rna_seq));
+}
+
+/**
+ * \brief DNA -> protein, without the intermediate RNA sequence.
+ *
+ * \param dna_seq    A DNA sequence.
+ * \return           A sequence of amino acids (to free with free).
+ */
+char *dna_translation(const char *dna_seq)
+{
+    return translation_n(dna_seq, strlen(dna_seq));
+}
+
+/**
+ * \brief Translate a compressed sequence.
+ *
+ * The codon indices are read directly from the bitfield. Codons overlapping a
+ * run of other residues are translated to 'X'.
+ *
+ * \param cs       The compressed sequence.
+ * \param table    The genetic code (see translation_table).
+ * \param amino    Where to write the length / 3 amino acids and a '\0'.
+ * \return         The number of amino acids.
+ */
+size_t cseq_translate(const cseq *cs, const char *table, char *amino)
+{
+    const size_t n_amino = cs->length / 3;
+    size_t a = 0;
+    for (; a < n_amino; ++a)
+    {
+        const unsigned int i = 3 * (unsigned int)a;
+        const unsigned int n1 = (cs->seq[i / CSEQ_WORD] >> (2 * (i % CSEQ_WORD))) & 3;
+        const unsigned int n2 = (cs->seq[(i + 1) / CSEQ_WORD] >> (2 * ((i + 1) % CSEQ_WORD))) & 3;
+        const unsigned int n3 = (cs->seq[(i + 2) / CSEQ_WORD] >> (2 * ((i + 2) % CSEQ_WORD))) & 3;
+        amino[a] = table[16 * n1 + 4 * n2 + n3];
+    }
+    unsigned int r = 0;
+    for (; r < cs->namb; ++r)
+    {
+        const unsigned int first = cs->amb[r].pos / 3;
+        const unsigned int last = (cs->amb[r].pos + cs->amb[r].length - 1) / 3;
+        unsigned int k = first;
+        for (; k <= last && k < n_amino; ++k)
+        {
+            amino[k] = 'X';
+        }
+    }
+    amino[n_amino] = '\0';
+    return n_amino;
+}
+
+/**
+ * \brief No position (see orf_scanner).
+ */
+#define ORF_NONE UINT64_MAX
+
+/**
+ * \brief An open reading frame, from a start codon to a stop codon.
+ *
+ * Positions are on the forward strand. On the forward strand, the start codon
+ * is at 'begin' and the stop codon ends at 'end'. On the reverse strand, the
+ * stop codon is at 'begin' and the start codon ends at 'end'.
+ */
+typedef struct
+{
+    uint64_t begin; /**< Position of the first nucleotide. */
+
+    uint64_t end; /**< Position after the last nucleotide. */
+
+    int strand; /**< 1 for the forward strand, -1 for the reverse strand. */
+}
+orf;
+
+/**
+ * \brief Called for each open reading frame found.
+ */
+typedef void (*orf_callback)(const orf *o, void *data);
+
+/**
+ * \brief Six-frame open reading frame scanner for sequences read in chunks.
+ *
+ * The codon ending at each position is kept for both strands and updated with
+ * a shift per nucleotide. A forward ORF starts at the first start codon after
+ * a stop codon. A reverse ORF is seen backward: from a stop codon to the last
+ * start codon before the next stop codon (in the same frame).
+ */
+typedef struct
+{
+    unsigned char flags[64]; /**< 1 for start codons, 2 for stop codons. */
+
+    unsigned int min_codons; /**< Minimum number of codons (without the stop codon). */
+
+    orf_callback callback; /**< Called for each ORF. */
+
+    void *data; /**< Passed to the callback. */
+
+    uint64_t pos; /**< Number of nucleotides fed so far. */
+
+    unsigned int valid; /**< Number of valid nucleotides before pos (up to 3). */
+
+    unsigned int fwd; /**< Index of the last codon on the forward strand. */
+
+    unsigned int rev; /**< Index of the last codon on the reverse strand. */
+
+    uint64_t fwd_start[3]; /**< Start of the open forward ORF in each frame. */
+
+    uint64_t rev_stop[3]; /**< Last reverse stop codon in each frame. */
+
+    uint64_t rev_start[3]; /**< Last reverse start codon after rev_stop in each frame. */
+}
+orf_scanner;
+
+/**
+ * \brief Initialize an ORF scanner.
+ *
+ * \param sc            A pointer to an unitialized 'orf_scanner' object.
+ * \param code          The genetic code (for start and stop codons).
+ * \param min_codons    Minimum number of codons of the reported ORFs (without the stop codon).
+ * \param callback      Called for each ORF.
+ * \param data          Passed to the callback.
+ */
+void orf_scanner_init(orf_scanner *sc, const genetic_code *code, unsigned int min_codons,
+                      orf_callback callback, void *data)
+{
+    unsigned int i = 0;
+    for (; i < 64; ++i)
+    {
+        sc->flags[i] = (code->start[i] ? 1 : 0) | (code->table[i] == 'Z' ? 2 : 0);
+    }
+    sc->min_codons = min_codons;
+    sc->callback = callback;
+    sc->data = data;
+    sc->pos = 0;
+    sc->valid = 0;
+    sc->fwd = 0;
+    sc->rev = 0;
+    for (i = 0; i < 3; ++i)
+    {
+        sc->fwd_start[i] = ORF_NONE;
+        sc->rev_stop[i] = ORF_NONE;
+        sc->rev_start[i] = ORF_NONE;
+    }
+}
+
+/**
+ * \brief Report an ORF if it is long enough.
+ */
+void orf_report(orf_scanner *sc, uint64_t begin, uint64_t end, int strand)
+{
+    if ((end - begin) / 3 - 1 >= sc->min_codons)
+    {
+        orf o;
+        o.begin = begin;
+        o.end = end;
+        o.strand = strand;
+        sc->callback(&o, sc->data);
+    }
+}
+
+/**
+ * \brief Feed one nucleotide (0 to 3 for 'A', 'C', 'G', 'T', 4 for the others) to an ORF scanner.
+ */
+void orf_scanner_push(orf_scanner *sc, unsigned int n)
+{
+    const uint64_t pos = sc->pos++;
+    if (n > 3)
+    {
+        sc->valid = 0;
+        return;
+    }
+    sc->fwd = ((sc->fwd << 2) | n) & 63;
+    sc->rev = (sc->rev >> 2) | ((3 - n) << 4);
+    if (sc->valid < 3 && ++sc->valid < 3)
+    {
+        return;
+    }
+    const uint64_t begin = pos - 2;
+    const unsigned int frame = (unsigned int)(begin % 3);
+    const unsigned char f = sc->flags[sc->fwd];
+    const unsigned char r = sc->flags[sc->rev];
+    if ((f & 2) && sc->fwd_start[frame] != ORF_NONE)
+    {
+        orf_report(sc, sc->fwd_start[frame], pos + 1, 1);
+        sc->fwd_start[frame] = ORF_NONE;
+    }
+    else if ((f & 1) && sc->fwd_start[frame] == ORF_NONE)
+    {
+        sc->fwd_start[frame] = begin;
+    }
+    if (r & 2)
+    {
+        if (sc->rev_start[frame] != ORF_NONE)
+        {
+            orf_report(sc, sc->rev_stop[frame], sc->rev_start[frame] + 3, -1);
+        }
+        sc->rev_stop[frame] = begin;
+        sc->rev_start[frame] = ORF_NONE;
+    }
+    else if ((r & 1) && sc->rev_stop[frame] != ORF_NONE)
+    {
+        sc->rev_start[frame] = begin;
+    }
+}
+
+/**
+ * \brief Feed the next chunk of the sequence to an ORF scanner.
+ *
+ * \param sc        The scanner.
+ * \param seq       The chunk (DNA or RNA, any case).
+ * \param length    Length of the chunk.
+ */
+void orf_scanner_feed(orf_scanner *sc, const char *seq, size_t length)
+{
+    size_t i = 0;
+    for (; i < length; ++i)
+    {
+        orf_scanner_push(sc, codon_code[(unsigned char)seq[i]]);
+    }
+}
+
+/**
+ * \brief Feed a compressed sequence to an ORF scanner.
+ *
+ * \param sc    The scanner.
+ * \param cs    The compressed sequence.
+ */
+void orf_scanner_feed_cseq(orf_scanner *sc, const cseq *cs)
+{
+    unsigned int r = 0;
+    unsigned int i = 0;
+    for (; i < cs->length; ++i)
+    {
+        while (r < cs->namb && cs->amb[r].pos + cs->amb[r].length <= i)
+        {
+            ++r;
+        }
+        const int other = (r < cs->namb && cs->amb[r].pos <= i);
+        orf_scanner_push(sc, other ? 4 : (unsigned int)((cs->seq[i / CSEQ_WORD] >> (2 * (i % CSEQ_WORD))) & 3));
+    }
+}
+
+/**
+ * \brief Report the reverse ORFs still open at the end of the sequence.
+ *
+ * \param sc    The scanner.
+ */
+void orf_scanner_finish(orf_scanner *sc)
+{
+    unsigned int frame = 0;
+    for (; frame < 3; ++frame)
+    {
+        if (sc->rev_start[frame] != ORF_NONE)
+        {
+            orf_report(sc, sc->rev_stop[frame], sc->rev_start[frame] + 3, -1);
+            sc->rev_start[frame] = ORF_NONE;
+        }
+    }
+}
+
+/**
+ * \brief Find the open reading frames of a sequence on both strands.
+ *
+ * \param seq           A DNA or RNA sequence.
+ * \param length        Length of the sequence.
+ * \param code          The genetic code (for start and stop codons).
+ * \param min_codons    Minimum number of codons (without the stop codon).
+ * \param callback      Called for each ORF.
+ * \param data          Passed to the callback.
+ */
+void orf_scan(const char *seq, size_t length, const genetic_code *code, unsigned int min_codons,
+              orf_callback callback, void *data)
+{
+    orf_scanner sc;
+    orf_scanner_init(&sc, code, min_codons, callback, data);
+    orf_scanner_feed(&sc, seq, length);
+    orf_scanner_finish(&sc);
+}
+
+/**
+ * \brief Find the open reading frames of a compressed sequence on both strands.
+ *
+ * \param cs            The compressed sequence.
+ * \param code          The genetic code (for start and stop codons).
+ * \param min_codons    Minimum number of codons (without the stop codon).
+ * \param callback      Called for each ORF.
+ * \param data          Passed to the callback.
+ */
+void cseq_orf_scan(const cseq *cs, const genetic_code *code, unsigned int min_codons,
+                   orf_callback callback, void *data)
+{
+    orf_scanner sc;
+    orf_scanner_init(&sc, code, min_codons, callback, data);
+    orf_scanner_feed_cseq(&sc, cs);
+    orf_scanner_finish(&sc);
+}
+
+/**
+ * \brief A growing array of ORFs (used by orf_find).
+ */
+typedef struct
+{
+    orf *orfs; /**< The ORFs. */
+
+    size_t n; /**< Number of ORFs. */
+
+    size_t capacity; /**< Capacity of the array. */
+}
+orf_array;
+
+/**
+ * \brief Add an ORF to an orf_array.
+ */
+void orf_array_add(const orf *o, void *data)
+{
+    orf_array *array = (orf_array*)data;
+    if (array->n == array->capacity)
+    {
+        array->capacity = (array->capacity == 0) ? 64 : 2 * array->capacity;
+        array->orfs = (orf*)realloc((void*)array->orfs, array->capacity * sizeof(orf));
+    }
+    array->orfs[array->n++] = *o;
+}
+
+/**
+ * \brief Return the open reading frames of a sequence on both strands.
+ *
+ * \param seq           A DNA or RNA sequence.
+ * \param length        Length of the sequence.
+ * \param code          The genetic code (for start and stop codons).
+ * \param min_codons    Minimum number of codons (without the stop codon).
+ * \param n             Set to the number of ORFs.
+ * \return              The ORFs, in the order their last codon is read (to free with free).
+ */
+orf *orf_find(const char *seq, size_t length, const genetic_code *code, unsigned int min_codons, size_t *n)
+{
+    orf_array array;
+    array.orfs = NULL;
+    array.n = 0;
+    array.capacity = 0;
+    orf_scan(seq, length, code, min_codons, orf_array_add, &array);
+    *n = array.n;
+    return array.orfs;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -55,9 +55,9 @@ sll;
  */
 void sll_init(sll *l, void (*destroy)(void *data))
 {
-    sll->head = NULL;
-    sll->tail = NULL;
-    sll->destroy = destroy;
+    l->head = NULL;
+    l->tail = NULL;
+    l->destroy = destroy;
 }
 
 /**
@@ -72,13 +72,9 @@ void sll_init(sll *l, void (*destroy)(void *data))
  */
 sllnode *sll_get(sll *l, unsigned int i)
 {
-    if (i < 0)
-    {
-        return NULL;
-    } 
-    sllnode *node = sll->head;
+    sllnode *node = l->head;
     unsigned int j = 0;
-    for (; j < i; ++j)
+    for (; j < i && node != NULL; ++j)
     {
         node = node->next;
     }
@@ -95,12 +91,12 @@ void sll_add_head(sll *l, void *data)
 {
     sllnode *new_node = (sllnode*)malloc(sizeof(sllnode));
     new_node->data = data;
-    new_node->next = sll->head;
-    sll->head = new_node;
+    new_node->next = l->head;
+    l->head = new_node;
     
-    if (sll->tail == NULL)
+    if (l->tail == NULL)
     {
-        sll->tail = new_node;
+        l->tail = new_node;
     }
 }
 
@@ -119,6 +115,7 @@ void sll_add_after(sll *l, sllnode *node, void *data)
     if (node == NULL)
     {
         sll_add_head(l, data);
+        return;
     }
     sllnode *new_node = (sllnode*)malloc(sizeof(sllnode));
     new_node->data = data;
@@ -127,7 +124,7 @@ void sll_add_after(sll *l, sllnode *node, void *data)
     
     if (new_node->next == NULL)
     {
-        sll->tail = new_node;
+        l->tail = new_node;
     }
 }
 
@@ -155,15 +152,15 @@ void sll_add_tail(sll *l, void *data)
     new_node->data = data;
     new_node->next = NULL;
     
-    if (sll->head == NULL)
+    if (l->head == NULL)
     {
-        sll->head = new_node;
+        l->head = new_node;
     }
     else
     {
-        sll->tail->next = new_node;
+        l->tail->next = new_node;
     }
-    sll->tail = new_node;
+    l->tail = new_node;
 }
 
 /**
@@ -180,14 +177,18 @@ int sll_rm_next(sll *l, sllnode *node)
 {
     sllnode *old_node;
 
-    if (sll->head == NULL)
+    if (l->head == NULL)
     {
         return FALSE;
     }
     if (node == NULL)
     {
-        old_node = sll->head;
-        sll->head = sll->head->next;
+        old_node = l->head;
+        l->head = l->head->next;
+        if (l->head == NULL)
+        {
+            l->tail = NULL;
+        }
     }
     else
     {
@@ -200,10 +201,13 @@ int sll_rm_next(sll *l, sllnode *node)
 
         if (node->next == NULL)
         {
-            sll->tail = node;
+            l->tail = node;
         }
     }
-    l->destroy(old_node->data);
+    if (l->destroy != NULL)
+    {
+        l->destroy(old_node->data);
+    }
     free(old_node);
 
     return TRUE;
@@ -216,7 +220,7 @@ int sll_rm_next(sll *l, sllnode *node)
  */
 void sll_rm_all(sll *l)
 {
-    while(sll_rm_next(sll, NULL));
+    while(sll_rm_next(l, NULL));
 }
 
 /**
@@ -233,17 +237,17 @@ unsigned int sll_rm(sll *l, int foo(sllnode *node))
 {
     unsigned int removed = 0;
 
-    while (foo(l->head))
+    while (l->head != NULL && !foo(l->head))
     {
-        sll_rm_next(sll, NULL);
+        sll_rm_next(l, NULL);
         ++removed;
     }
-    sllnode *node = sll->head;
-    while (node->next != NULL)
+    sllnode *node = l->head;
+    while (node != NULL && node->next != NULL)
     {
-        if (foo(node->next))
+        if (!foo(node->next))
         {
-            sll_rm_next(sll, node);
+            sll_rm_next(l, node);
             ++removed;
         }
         else
@@ -254,6 +258,24 @@ unsigned int sll_rm(sll *l, int foo(sllnode *node))
     return removed;
 }
 
+/**
+ * \brief Return the length.
+ * 
+ * \param l    The singly linked list.
+ * \return     Number of nodes in the list.
+ */
+unsigned int sll_length(const sll *l)
+{
+    unsigned int length = 0;
+    sllnode *node = l->head;
+    while (node != NULL)
+    {
+        ++length;
+        node = node->next;
+    }
+    return length;
+}
+
 /**
  * \brief Generates an array from the data inside all the nodes.
  * 
@@ -265,7 +287,7 @@ void **sll_as_array(sll *l)
     void **data = (void**)malloc(sll_length(l) * sizeof(void*));
 
     int i = 0;
-    sllnode *node = sll->head;
+    sllnode *node = l->head;
     for (; node != NULL; node = node->next)
     {
         data[i++] = node->data;
@@ -274,30 +296,27 @@ void **sll_as_array(sll *l)
 }
 
 /**
- * \brief Return the length.
+ * \brief Free the memory of the list.
+ *
+ * Free the memory of the list but doesn't touch the void pointers.
  * 
- * \param l    The singly linked list.
- * \return     Number of nodes in the list.
+ * \param l    The singly linked list to free.
  */
-unsigned int sll_length(const sll *l)
+void sll_free(sll *l)
 {
-    unsigned int length = 0;
-    sllnode *node = sll->head;
+    sllnode *node = l->head;
     while (node != NULL)
     {
-        ++length;
-        node = node->next;
+        sllnode *next = node->next;
+        free(node);
+        node = next;
     }
-    return length;
+    l->head = NULL;
+    l->tail = NULL;
 }
 
-/**
- * \brief Free the memory of the list.
- *
- * Free the memory of the list but doesn't touch the void pointers.
- * 
- * \param l    The singly linked list to free.
- */
-void sll_free(sll *l);
+#ifdef __cplusplus
+}
+#endif
 
 #endif
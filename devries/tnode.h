@@ -28,6 +28,8 @@ typedef struct tnode_
 
     struct tnode_ *p; /**< Pointer to the parent. */
 
+    double length; /**< Length of the branch leading to the parent. */
+
     unsigned int n; /**< Number of children. */
     
     sll children; /**< Singly linked list of children. */
@@ -44,7 +46,31 @@ tnode;
  * 
  * \param t    The root of the tree to free.
  */
-void tnode_free(tnode *t); /* Add a void function for genericity. */
+void tnode_free(tnode *t) /* Add a void function for genericity. */
+{
+    /* Explicit stack, deep (caterpillar) trees would blow the call stack. */
+    size_t capacity = 64;
+    size_t top = 0;
+    tnode **stack = (tnode**)malloc(capacity * sizeof(tnode*));
+    stack[top++] = t;
+    while (top > 0)
+    {
+        tnode *node = stack[--top];
+        sllnode *n = node->children.head;
+        for (; n != NULL; n = n->next)
+        {
+            if (top == capacity)
+            {
+                capacity *= 2;
+                stack = (tnode**)realloc(stack, capacity * sizeof(tnode*));
+            }
+            stack[top++] = (tnode*)(n->data);
+        }
+        sll_free(&node->children);
+        free(node);
+    }
+    free(stack);
+}
 
 /**
  * \brief Initialize a tree object.
@@ -60,10 +86,10 @@ tnode *tnode_init(tnode *p, char *name, void *data)
 
     t->name = name;
     t->p = p;
-    t->l = NULL;
-    t->r = NULL;
+    t->length = 0.0;
+    t->n = 0;
     t->data = data;
-    t->children.destroy = NULL; /* For now... Mwhahaha! */
+    sll_init(&t->children, NULL); /* For now... Mwhahaha! */
 
     return t;
 }
@@ -77,7 +103,50 @@ tnode *tnode_init(tnode *p, char *name, void *data)
 void tnode_add_children(tnode *t, tnode *child)
 {
     ++(t->n);
-    sll_add_tail(t->children, (void*)(child))
+    sll_add_tail(&t->children, (void*)(child));
+}
+
+/**
+ * \brief Count the nodes and the leaves of a subtree.
+ *
+ * \param t        The subtree to analyze.
+ * \param nleaves  Where to write the number of leaves (can be NULL).
+ * \return         The number of nodes in the subtree (t included).
+ */
+unsigned int tnode_count(tnode *t, unsigned int *nleaves)
+{
+    /* Explicit stack, like tnode_free. */
+    size_t capacity = 64;
+    size_t top = 0;
+    tnode **stack = (tnode**)malloc(capacity * sizeof(tnode*));
+    unsigned int nnodes = 0;
+    unsigned int leaves = 0;
+    stack[top++] = t;
+    while (top > 0)
+    {
+        tnode *node = stack[--top];
+        ++nnodes;
+        if (node->n == 0)
+        {
+            ++leaves;
+        }
+        sllnode *n = node->children.head;
+        for (; n != NULL; n = n->next)
+        {
+            if (top == capacity)
+            {
+                capacity *= 2;
+                stack = (tnode**)realloc(stack, capacity * sizeof(tnode*));
+            }
+            stack[top++] = (tnode*)(n->data);
+        }
+    }
+    free(stack);
+    if (nleaves != NULL)
+    {
+        *nleaves = leaves;
+    }
+    return nnodes;
 }
 
 /**
@@ -88,13 +157,7 @@ void tnode_add_children(tnode *t, tnode *child)
  */
 unsigned int tnode_nedges(tnode *t)
 {
-    unsigned int nedges = 0;
-    sllnode *n = t->children->head;
-    for (; n != NULL; n = n->next)
-    {
-        nedges += tnode_nedges((tnode*)(n->data));
-    }
-    return nedges;
+    return tnode_count(t, NULL) - 1;
 }
 
 /**
@@ -105,7 +168,9 @@ unsigned int tnode_nedges(tnode *t)
  */
 unsigned int tnode_nleaves(tnode *t)
 {
-    return 1 + tnode_nedges(t) / 2;
+    unsigned int nleaves = 0;
+    tnode_count(t, &nleaves);
+    return nleaves;
 }
 
 /**
@@ -119,6 +184,30 @@ unsigned int tnode_toroot(tnode *t)
     return (t->p == NULL) ? 0 : 1 + tnode_toroot(t->p);
 }
 
+/**
+ * \brief Nodes between this node and the root.
+ *
+ * \param t    The node.
+ * \param n    Where to write the number of nodes (the node and the root included).
+ * \return     An array from the node to the root (to free with free).
+ */
+tnode **tnode_path(tnode *t, size_t *n)
+{
+    size_t capacity = 64;
+    tnode **path = (tnode**)malloc(capacity * sizeof(tnode*));
+    *n = 0;
+    for (; t != NULL; t = t->p)
+    {
+        if (*n == capacity)
+        {
+            capacity *= 2;
+            path = (tnode**)realloc(path, capacity * sizeof(tnode*));
+        }
+        path[(*n)++] = t;
+    }
+    return path;
+}
+
 #ifndef NDEBUG
 /**
  * \brief Return 'true' if the node is a leaf.
@@ -153,10 +242,9 @@ int tnode_internal(tnode *t)
     return ((t->n > 0) && t->p != NULL);
 }
 #else
-#ifndef NDEBUG
 #define tnode_leaf(t)       ((t)->n==0)
 #define tnode_root(t)       ((t)->p==NULL)
-#define tnode_internal(t)   (((t)->children->length>0)&&t->p!=NULL)
+#define tnode_internal(t)   (((t)->n>0)&&(t)->p!=NULL)
 #endif
 
 /**
@@ -167,7 +255,8 @@ int tnode_internal(tnode *t)
  */
 char *tnode_newick(tnode *t)
 {
-    char *str;
+    (void)t;
+    char *str = NULL;
     /*
     if (tnode_leaf(t))
     {
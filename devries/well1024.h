@@ -12,6 +12,10 @@
 #include <string.h>
 #include <math.h>
 #include <limits.h>
+#include <stdint.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 // For C++ compilers:
 #ifdef __cplusplus
@@ -63,7 +67,8 @@ void well1024_init(well1024 *rng, unsigned int seed)
     }
 }
 
-/** Initialize with time using time_seed(). Return the seed used. */
+/** Initialize with time using time_seed(). Return the seed used.
+ *  Generators initialized in the same second get the same seed: use well1024_split for threads. */
 unsigned int well1024_init_time(well1024 *rng)
 {
     unsigned int seed = 0;
@@ -79,8 +84,8 @@ unsigned int well1024_init_time(well1024 *rng)
     return seed;
 }
 
-/** Return a double in the [0, 1) range. */
-double well1024_next_double(well1024 *rng)
+/** Return the next 32 random bits. */
+unsigned int well1024_next_uint32(well1024 *rng)
 {
     unsigned int *const state = rng->state;
     const unsigned int state_n = rng->state_n;
@@ -92,7 +97,337 @@ double well1024_next_double(well1024 *rng)
     state[(state_n + 31) & 0x0000001fUL] = WELL_MAT3NEG(-11,z0) ^ WELL_MAT3NEG(-7,z1) ^ WELL_MAT3NEG(-13,z2) ;
     rng->state_n = (state_n + 31) & 0x0000001fUL;
 
-    return ((double)state[rng->state_n] * 2.32830643653869628906e-10);
+    return state[rng->state_n];
+}
+
+/** Return a double in the [0, 1) range. */
+double well1024_next_double(well1024 *rng)
+{
+    return ((double)well1024_next_uint32(rng) * 2.32830643653869628906e-10);
+}
+
+/** Return an integer in the [0, s) semi-closed range without bias (Lemire's multiply-shift with rejection). */
+unsigned int well1024_next_bounded(well1024 *rng, unsigned int s)
+{
+    assert(s > 0);
+    uint64_t m = (uint64_t)well1024_next_uint32(rng) * s;
+    unsigned int l = (unsigned int)m;
+    if (l < s)
+    {
+        // Reject the 2^32 mod s lowest values so each result has the same number of 32-bit numbers.
+        const unsigned int threshold = (0U - s) % s;
+        while (l < threshold)
+        {
+            m = (uint64_t)well1024_next_uint32(rng) * s;
+            l = (unsigned int)m;
+        }
+    }
+    return (unsigned int)(m >> 32);
+}
+
+// BULK
+
+/** Fill an array with 32-bit random numbers (same numbers as n calls to well1024_next_uint32). */
+void well1024_fill_uint32(well1024 *rng, unsigned int *dst, size_t n)
+{
+    unsigned int *const state = rng->state;
+    unsigned int state_n = rng->state_n;
+    size_t i = 0;
+    for (; i < n; ++i)
+    {
+        const unsigned int z0 = state[(state_n + 31) & 0x1fU];
+        const unsigned int z1 = WELL_IDEN(state[state_n]) ^ WELL_MAT3POS(8, state[(state_n + 3) & 0x1fU]);
+        const unsigned int z2 = WELL_MAT3NEG(-19, state[(state_n + 24) & 0x1fU]) ^ WELL_MAT3NEG(-14, state[(state_n + 10) & 0x1fU]);
+        state[state_n] = z1 ^ z2;
+        state_n = (state_n + 31) & 0x1fU;
+        state[state_n] = WELL_MAT3NEG(-11, z0) ^ WELL_MAT3NEG(-7, z1) ^ WELL_MAT3NEG(-13, z2);
+        dst[i] = state[state_n];
+    }
+    rng->state_n = state_n;
+}
+
+/** Fill an array with doubles in the [0, 1) range (same numbers as n calls to well1024_next_double). */
+void well1024_fill_double(well1024 *rng, double *dst, size_t n)
+{
+    unsigned int bits[256];
+    size_t i = 0;
+    while (i < n)
+    {
+        const size_t m = (n - i < 256) ? n - i : 256;
+        well1024_fill_uint32(rng, bits, m);
+        size_t j = 0;
+        for (; j < m; ++j)
+        {
+            dst[i + j] = (double)bits[j] * 2.32830643653869628906e-10;
+        }
+        i += m;
+    }
+}
+
+/** Fill an array with integers in the [0, b) semi-closed range (same numbers as n calls to well1024_next_int). */
+void well1024_fill_int(well1024 *rng, int *dst, size_t n, int b)
+{
+    assert(b > 0);
+    const unsigned int s = (unsigned int)b;
+    const unsigned int threshold = (0U - s) % s;
+    unsigned int bits[256];
+    size_t nbits = 0, used = 0;
+    size_t i = 0;
+    while (i < n)
+    {
+        if (used == nbits)
+        {
+            // Never more numbers than needed, so the generator ends where n calls would.
+            nbits = (n - i < 256) ? n - i : 256;
+            well1024_fill_uint32(rng, bits, nbits);
+            used = 0;
+        }
+        const uint64_t m = (uint64_t)bits[used++] * s;
+        if ((unsigned int)m >= threshold)
+        {
+            dst[i++] = (int)(m >> 32);
+        }
+    }
+}
+
+// JUMP AHEAD
+
+/** Characteristic polynomial of the WELL1024a recurrence over GF(2): bit i is the coefficient of x^i (x^1024 is implicit).
+ *  Found with the Berlekamp-Massey algorithm on 2048 output bits (the degree is 1024, the size of the state). */
+static const unsigned int well1024_charpoly[32] =
+{
+    0x00000001U, 0x00000000U, 0x00000000U, 0x00000000U,
+    0x028a0008U, 0x02288020U, 0x2baaa20aU, 0x0209aa00U,
+    0x3f871248U, 0x80172a7bU, 0xee101d14U, 0xef2221f3U,
+    0xb5bf7be1U, 0xab57e80cU, 0xfa24ee53U, 0x37dab9aaU,
+    0xd353180bU, 0xf1c5d9edU, 0xd6465866U, 0x7a048625U,
+    0x892b7ef6U, 0x2ca9170fU, 0xa8a3f324U, 0x36be065fU,
+    0x57aee2abU, 0xb20f4dd9U, 0xa0eaa2eeU, 0xa678c37aU,
+    0x5792d2aeU, 0xac449456U, 0x51549f89U, 0x00000000U
+};
+
+/** Square a polynomial of degree < 1024 modulo the characteristic polynomial. */
+void well1024_poly_square(unsigned int poly[32])
+{
+    unsigned int sq[64];
+    int i = 0;
+    for (; i < 32; ++i)
+    {
+        // Squaring in GF(2) spreads the bits: bit j goes to bit 2j.
+        unsigned int lo = 0, hi = 0;
+        int b = 0;
+        for (; b < 16; ++b)
+        {
+            lo |= ((poly[i] >> b) & 1U) << (2 * b);
+            hi |= ((poly[i] >> (b + 16)) & 1U) << (2 * b);
+        }
+        sq[2 * i] = lo;
+        sq[2 * i + 1] = hi;
+    }
+    // x^1024 = the low part of the polynomial, reduce from the highest bit.
+    for (i = 2047; i >= 1024; --i)
+    {
+        if (sq[i / 32] & (1U << (i % 32)))
+        {
+            sq[i / 32] ^= 1U << (i % 32);
+            const int shift = i - 1024;
+            const int w = shift / 32, b = shift % 32;
+            int j = 0;
+            for (; j < 32; ++j)
+            {
+                sq[j + w] ^= well1024_charpoly[j] << b;
+                if (b > 0)
+                {
+                    sq[j + w + 1] ^= well1024_charpoly[j] >> (32 - b);
+                }
+            }
+        }
+    }
+    memcpy(poly, sq, 32 * sizeof(unsigned int));
+}
+
+/** Set poly to x^(2^k) modulo the characteristic polynomial (the jump polynomial for 2^k steps). */
+void well1024_jump_poly_pow2(unsigned int poly[32], unsigned int k)
+{
+    memset(poly, 0, 32 * sizeof(unsigned int));
+    poly[0] = 2U; // x
+    unsigned int i = 0;
+    for (; i < k; ++i)
+    {
+        well1024_poly_square(poly);
+    }
+}
+
+/** Apply a jump polynomial q (the state becomes q(T) applied to the state, by Horner's method). */
+void well1024_jump_poly(well1024 *rng, const unsigned int poly[32])
+{
+    // The state in the order used by the recurrence, independent of state_n.
+    unsigned int start[32];
+    int j = 0;
+    for (; j < 32; ++j)
+    {
+        start[j] = rng->state[(rng->state_n + j) & 0x1fU];
+    }
+    well1024 acc;
+    memset(&acc, 0, sizeof(well1024));
+    acc.state_n = rng->state_n;
+    int i = 1023;
+    for (; i >= 0; --i)
+    {
+        well1024_next_uint32(&acc);
+        if (poly[i / 32] & (1U << (i % 32)))
+        {
+            for (j = 0; j < 32; ++j)
+            {
+                acc.state[(acc.state_n + j) & 0x1fU] ^= start[j];
+            }
+        }
+    }
+    // 1024 steps: acc.state_n is back to rng->state_n.
+    memcpy(rng->state, acc.state, sizeof(acc.state));
+    rng->have_next_normal = FALSE;
+}
+
+/** Skip the next 2^k numbers (k < 1024) in O(k) polynomial squarings, without generating them. */
+void well1024_jump(well1024 *rng, unsigned int k)
+{
+    assert(k < 1024);
+    unsigned int poly[32];
+    well1024_jump_poly_pow2(poly, k);
+    well1024_jump_poly(rng, poly);
+}
+
+/** Split a generator in n streams 2^512 numbers apart (stream 0 is a copy of master, master is unchanged).
+ *  Use one stream per thread: the streams are reproducible and will never overlap. */
+void well1024_split(const well1024 *master, unsigned int n, well1024 *streams)
+{
+    if (n == 0)
+    {
+        return;
+    }
+    unsigned int poly[32];
+    well1024_jump_poly_pow2(poly, 512);
+    streams[0] = *master;
+    streams[0].have_next_normal = FALSE;
+    unsigned int i = 1;
+    for (; i < n; ++i)
+    {
+        streams[i] = streams[i - 1];
+        well1024_jump_poly(&streams[i], poly);
+    }
+}
+
+// MULTI-LANE GENERATOR
+
+/** Four independent well1024 generators advanced together (with SSE2 if available). */
+typedef struct
+{
+    unsigned int state[32][4]; // state[i][j] is word i of lane j
+    unsigned int state_n;
+    unsigned int seed; // The initial seed used to initiate the generator
+}
+well1024x4;
+
+/** Set the lanes to the states of four well1024 generators (at the same state_n). */
+void well1024x4_set_lanes(well1024x4 *rng, const well1024 lanes[4])
+{
+    rng->seed = lanes[0].seed;
+    rng->state_n = lanes[0].state_n;
+    int j = 0;
+    for (; j < 4; ++j)
+    {
+        assert(lanes[j].state_n == rng->state_n);
+        int i = 0;
+        for (; i < 32; ++i)
+        {
+            rng->state[i][j] = lanes[j].state[i];
+        }
+    }
+}
+
+/** Use 4 streams of well1024_split(master) as lanes, so the lanes never overlap. */
+void well1024x4_init_split(well1024x4 *rng, const well1024 *master)
+{
+    well1024 lanes[4];
+    well1024_split(master, 4, lanes);
+    well1024x4_set_lanes(rng, lanes);
+}
+
+/** Seed the lanes with well1024x4_init_split on a well1024 seeded with seed (lane 0 is well1024_init(seed)). */
+void well1024x4_init(well1024x4 *rng, unsigned int seed)
+{
+    assert(seed != 0);
+    well1024 master;
+    well1024_init(&master, seed);
+    well1024x4_init_split(rng, &master);
+}
+
+/** Write the next 32-bit number of each lane in out. */
+void well1024x4_next(well1024x4 *rng, unsigned int out[4])
+{
+    unsigned int (*const state)[4] = rng->state;
+    const unsigned int state_n = rng->state_n;
+    const unsigned int m = (state_n + 31) & 0x1fU;
+#if defined(__SSE2__)
+    const __m128i z0 = _mm_loadu_si128((const __m128i*)state[m]);
+    const __m128i v0 = _mm_loadu_si128((const __m128i*)state[state_n]);
+    const __m128i v1 = _mm_loadu_si128((const __m128i*)state[(state_n + 3) & 0x1fU]);
+    const __m128i v2 = _mm_loadu_si128((const __m128i*)state[(state_n + 24) & 0x1fU]);
+    const __m128i v3 = _mm_loadu_si128((const __m128i*)state[(state_n + 10) & 0x1fU]);
+    const __m128i z1 = _mm_xor_si128(v0, _mm_xor_si128(v1, _mm_srli_epi32(v1, 8)));
+    const __m128i z2 = _mm_xor_si128(_mm_xor_si128(v2, _mm_slli_epi32(v2, 19)),
+                                     _mm_xor_si128(v3, _mm_slli_epi32(v3, 14)));
+    const __m128i r = _mm_xor_si128(_mm_xor_si128(_mm_xor_si128(z0, _mm_slli_epi32(z0, 11)),
+                                                  _mm_xor_si128(z1, _mm_slli_epi32(z1, 7))),
+                                    _mm_xor_si128(z2, _mm_slli_epi32(z2, 13)));
+    _mm_storeu_si128((__m128i*)state[state_n], _mm_xor_si128(z1, z2));
+    _mm_storeu_si128((__m128i*)state[m], r);
+    _mm_storeu_si128((__m128i*)out, r);
+#else
+    int j = 0;
+    for (; j < 4; ++j)
+    {
+        const unsigned int z0 = state[m][j];
+        const unsigned int z1 = WELL_IDEN(state[state_n][j]) ^ WELL_MAT3POS(8, state[(state_n + 3) & 0x1fU][j]);
+        const unsigned int z2 = WELL_MAT3NEG(-19, state[(state_n + 24) & 0x1fU][j]) ^ WELL_MAT3NEG(-14, state[(state_n + 10) & 0x1fU][j]);
+        state[state_n][j] = z1 ^ z2;
+        state[m][j] = WELL_MAT3NEG(-11, z0) ^ WELL_MAT3NEG(-7, z1) ^ WELL_MAT3NEG(-13, z2);
+        out[j] = state[m][j];
+    }
+#endif
+    rng->state_n = m;
+}
+
+/** Fill an array with 32-bit random numbers, lane 0, 1, 2, 3, 0, ... (the unused numbers of the last step are lost). */
+void well1024x4_fill_uint32(well1024x4 *rng, unsigned int *dst, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        well1024x4_next(rng, dst + i);
+    }
+    if (i < n)
+    {
+        unsigned int out[4];
+        well1024x4_next(rng, out);
+        memcpy(dst + i, out, (n - i) * sizeof(unsigned int));
+    }
+}
+
+/** Fill an array with doubles in the [0, 1) range, lane 0, 1, 2, 3, 0, ... */
+void well1024x4_fill_double(well1024x4 *rng, double *dst, size_t n)
+{
+    unsigned int out[4];
+    size_t i = 0;
+    for (; i < n; i += 4)
+    {
+        well1024x4_next(rng, out);
+        size_t j = 0;
+        for (; j < 4 && i + j < n; ++j)
+        {
+            dst[i + j] = (double)out[j] * 2.32830643653869628906e-10;
+        }
+    }
 }
 
 // UNIFORM DISTRIBUTION
@@ -100,22 +435,24 @@ double well1024_next_double(well1024 *rng)
 /** Return an integer in the [0, b) semi-closed range. */
 int well1024_next_int(well1024 *rng, int b)
 {
-    return (int)(well1024_next_double(rng) * b);
+    assert(b > 0);
+    return (int)well1024_next_bounded(rng, (unsigned int)b);
 }
 
 unsigned int well1024_next_uint(well1024 *rng, int b)
 {
-    return (unsigned int)(well1024_next_double(rng) * b);
+    assert(b > 0);
+    return well1024_next_bounded(rng, (unsigned int)b);
 }
 
 int well1024_next_max_int(well1024 *rng)
 {
-    return (int)(well1024_next_double(rng) * INT_MAX);
+    return (int)well1024_next_bounded(rng, INT_MAX);
 }
 
 unsigned int well1024_next_max_uint(well1024 *rng)
 {
-    return (int)(well1024_next_double(rng) * UINT_MAX);
+    return well1024_next_bounded(rng, UINT_MAX);
 }
 
 // NON-UNIFORM DISTRIBUTIONS
@@ -163,8 +500,414 @@ double well1024_next_normal(well1024 *rng)
     }
 }
 
-/** Return an integer from a poisson distribution given lambda. \f$O(\lambda)\f$. */
-int well1024_next_poisson(well1024 *rng, double lambda)
+// ZIGGURAT TABLES (Marsaglia and Tsang, 2000), 128 layers for the normal, 256 for the exponential.
+// Precomputed with r = 3.442619855899, v = 9.91256303526217e-3 (normal) and r = 7.697117470131487,
+// v = 3.949659822581572e-3 (exponential), so the _zig functions need no initialization.
+
+/** Normal: accept |x| directly below kn[i]. */
+static const unsigned int well1024_zig_kn[128] =
+{
+    0x76ad2212U, 0x00000000U, 0x600f1b53U, 0x6ce447a6U,
+    0x725b46a2U, 0x7560051dU, 0x774921ebU, 0x789a25bdU,
+    0x799045c3U, 0x7a4bce5dU, 0x7adf629fU, 0x7b5682a6U,
+    0x7bb8a8c6U, 0x7c0ae722U, 0x7c50cce7U, 0x7c8cec5bU,
+    0x7cc12cd6U, 0x7ceefed2U, 0x7d177e0bU, 0x7d3b8883U,
+    0x7d5bce6cU, 0x7d78dd64U, 0x7d932886U, 0x7dab0e57U,
+    0x7dc0dd30U, 0x7dd4d688U, 0x7de73185U, 0x7df81ceaU,
+    0x7e07c0a3U, 0x7e163efaU, 0x7e23b587U, 0x7e303dfdU,
+    0x7e3beec2U, 0x7e46db77U, 0x7e51155dU, 0x7e5aabb3U,
+    0x7e63abf7U, 0x7e6c222cU, 0x7e741906U, 0x7e7b9a18U,
+    0x7e82adfaU, 0x7e895c63U, 0x7e8fac4bU, 0x7e95a3fbU,
+    0x7e9b4924U, 0x7ea0a0efU, 0x7ea5b00dU, 0x7eaa7ac3U,
+    0x7eaf04f3U, 0x7eb3522aU, 0x7eb765a5U, 0x7ebb4259U,
+    0x7ebeeafdU, 0x7ec2620aU, 0x7ec5a9c4U, 0x7ec8c441U,
+    0x7ecbb365U, 0x7ece78edU, 0x7ed11671U, 0x7ed38d62U,
+    0x7ed5df12U, 0x7ed80cb4U, 0x7eda175cU, 0x7edc0005U,
+    0x7eddc78eU, 0x7edf6ebfU, 0x7ee0f647U, 0x7ee25ebeU,
+    0x7ee3a8a9U, 0x7ee4d473U, 0x7ee5e276U, 0x7ee6d2f5U,
+    0x7ee7a620U, 0x7ee85c10U, 0x7ee8f4cdU, 0x7ee97047U,
+    0x7ee9ce59U, 0x7eea0ecaU, 0x7eea3147U, 0x7eea3568U,
+    0x7eea1aabU, 0x7ee9e071U, 0x7ee98602U, 0x7ee90a88U,
+    0x7ee86d08U, 0x7ee7ac6aU, 0x7ee6c769U, 0x7ee5bc9cU,
+    0x7ee48a67U, 0x7ee32efcU, 0x7ee1a857U, 0x7edff42fU,
+    0x7ede0ffaU, 0x7edbf8d9U, 0x7ed9ab94U, 0x7ed7248dU,
+    0x7ed45faeU, 0x7ed1585cU, 0x7ece095fU, 0x7eca6ccbU,
+    0x7ec67be2U, 0x7ec22eeeU, 0x7ebd7d1aU, 0x7eb85c35U,
+    0x7eb2c075U, 0x7eac9c20U, 0x7ea5df27U, 0x7e9e769fU,
+    0x7e964c16U, 0x7e8d44baU, 0x7e834033U, 0x7e781728U,
+    0x7e6b9933U, 0x7e5d8a1aU, 0x7e4d9dedU, 0x7e3b737aU,
+    0x7e268c2fU, 0x7e0e3ff5U, 0x7df1aa5dU, 0x7dcf8c72U,
+    0x7da61a1eU, 0x7d72a0fbU, 0x7d30e097U, 0x7cd9b4abU,
+    0x7c600f1aU, 0x7ba90bdcU, 0x7a722176U, 0x77d664e5U
+};
+
+/** Normal: width of layer i over 2^31. */
+static const double well1024_zig_wn[128] =
+{
+    1.729040521542798e-09, 1.2680928447002762e-10, 1.6897517773184551e-10, 1.9862688442479051e-10,
+    2.2232431792499955e-10, 2.4244936125448931e-10, 2.6016131900632064e-10, 2.7611988711703956e-10,
+    2.9073962817715979e-10, 3.0429970414376596e-10, 3.1699795213954273e-10, 3.2898020527113064e-10,
+    3.4035738121834064e-10, 3.5121602213664708e-10, 3.616250995056517e-10, 3.7164057634959785e-10,
+    3.8130856431105979e-10, 3.9066756809948822e-10, 3.9975011869976912e-10, 4.0858398615984403e-10,
+    4.1719309640160654e-10, 4.2559823534592626e-10, 4.3381759739255105e-10, 4.4186721812528858e-10,
+    4.4976131962665818e-10, 4.5751258894588287e-10, 4.6513240481400098e-10, 4.7263102384811756e-10,
+    4.800177347232567e-10, 4.8730098677987483e-10, 4.9448849805389729e-10, 5.0158734661196158e-10,
+    5.0860404824245599e-10, 5.15544622919539e-10, 5.2241465197063155e-10, 5.2921932750063053e-10,
+    5.3596349533128897e-10, 5.4265169248206189e-10, 5.4928818003460213e-10, 5.5587697207607733e-10,
+    5.6242186129835884e-10, 5.6892644173465501e-10, 5.7539412903756027e-10, 5.8182817863908979e-10,
+    5.8823170208121699e-10, 5.9460768176249956e-10, 6.0095898431083022e-10, 6.0728837276278847e-10,
+    6.1359851770541355e-10, 6.1989200751559216e-10, 6.2617135781494294e-10, 6.3243902024354019e-10,
+    6.3869739064357364e-10, 6.4494881673373833e-10, 6.5119560534646982e-10, 6.5744002929285993e-10,
+    6.6368433391398755e-10, 6.6993074337233023e-10, 6.7618146673274439e-10, 6.824387038791137e-10,
+    6.8870465131007329e-10, 6.949815078551667e-10, 7.0127148035131547e-10, 7.0757678931855602e-10,
+    7.138996746735849e-10, 7.2024240151974857e-10, 7.2660726605270474e-10, 7.329966016220864e-10,
+    7.3941278499112283e-10, 7.4585824283835391e-10, 7.5233545854834884e-10, 7.5884697934176525e-10,
+    7.6539542379922632e-10, 7.7198348983844004e-10, 7.786139632098381e-10, 7.8528972658289975e-10,
+    7.9201376930340978e-10, 7.9878919791135359e-10, 8.0561924752021698e-10, 8.1250729417139681e-10,
+    8.1945686829257451e-10, 8.2647166940666245e-10, 8.335555822587845e-10, 8.407126945532991e-10,
+    8.4794731652183716e-10, 8.5526400257760939e-10, 8.6266757535193633e-10, 8.7016315245744244e-10,
+    8.7775617638032838e-10, 8.8545244797372776e-10, 8.9325816410803695e-10, 9.0117996013566053e-10,
+    9.092249579511381e-10, 9.1740082057860052e-10, 9.257158144040126e-10, 9.3417888039884721e-10,
+    9.4279971596663144e-10, 9.5158886939988827e-10, 9.6055784938312528e-10, 9.697192525453944e-10,
+    9.7908691279089008e-10, 9.8867607706877244e-10, 9.9850361345354251e-10, 1.0085882589914473e-09,
+    1.0189509168621382e-09, 1.0296150152006668e-09, 1.0406069436999874e-09, 1.0519565892728039e-09,
+    1.0636979991930871e-09, 1.0758702101645819e-09, 1.0885182960607283e-09, 1.1016947078135044e-09,
+    1.1154610095597163e-09, 1.1298901613493216e-09, 1.1450695700067237e-09, 1.1611052426022348e-09,
+    1.1781275609456131e-09, 1.1962995053850756e-09, 1.2158286983295564e-09, 1.2369856290804966e-09,
+    1.2601323300608525e-09, 1.2857696844205153e-09, 1.3146201849677183e-09, 1.3477839562210855e-09,
+    1.3870635315067043e-09, 1.435740319181638e-09, 1.5008659030222993e-09, 1.6030947938091123e-09
+};
+
+/** Normal: density at the edge of layer i. */
+static const double well1024_zig_fn[128] =
+{
+    1.0, 0.96359969312708615, 0.93628268168505957, 0.9130436479717402,
+    0.8922816507840261, 0.87324304891006954, 0.85550060786945059, 0.83878360529598961,
+    0.82290721138140899, 0.80773829468296054, 0.79317701177130506, 0.7791460859296877,
+    0.7655841738977045, 0.75244155917461142, 0.73967724367264731, 0.72725691834418482,
+    0.7151515074104986, 0.70333609901615812, 0.69178914343667508, 0.68049184099733406,
+    0.66942766734889037, 0.65858200005008805, 0.64794182111022247, 0.6374954773350423,
+    0.62723248524992725, 0.61714337081888093, 0.60721953662512029, 0.59745315094451668,
+    0.58783705443470657, 0.57836468111976314, 0.56902999106795094, 0.55982741270408687,
+    0.55075179311460454, 0.5417983550254255, 0.53296265938383613, 0.52424057267298407,
+    0.51562823824400184, 0.50712205107556896, 0.4987186354709795, 0.49041482528384411,
+    0.48220764632948521, 0.47409430069301695, 0.46607215268945612, 0.45813871626787206,
+    0.45029164368203922, 0.44252871527546844, 0.43484783024999091, 0.42724699830499607,
+    0.41972433204957438, 0.412278040102661, 0.40490642080722294, 0.39760785649387331,
+    0.39038080823731458, 0.3832238110559012, 0.37613546951056259, 0.36911445366447221,
+    0.36215949536931757, 0.35526938484791709, 0.34844296754632659, 0.34167914123155041,
+    0.33497685331358917, 0.3283350983728503, 0.32175291587598492, 0.31522938806501088,
+    0.30876363800618112, 0.30235482778648354, 0.29600215684693298, 0.28970486044295984,
+    0.28346220822323298, 0.27727350291918812, 0.27113807913838461, 0.26505530225558921,
+    0.25902456739620483, 0.25304529850732577, 0.24711694751232141, 0.24123899354543982,
+    0.23541094226347908, 0.22963232523211613, 0.22390269938500842, 0.2182216465543054,
+    0.2125887730717303, 0.20700370943992652, 0.20146611007431367, 0.19597565311627774,
+    0.19053204031913715, 0.18513499700899219, 0.17978427212329545, 0.1744796383307895,
+    0.169220892237365, 0.16400785468342038, 0.1588403711394793, 0.15371831220818166,
+    0.14864157424234226, 0.14361008009062776, 0.1386237799845946, 0.13368265258343937,
+    0.12878670619594321, 0.12393598020286782, 0.11913054670765083, 0.11437051244886601,
+    0.10965602101484027, 0.10498725540942132, 0.10036444102865587, 0.095787849121731439,
+    0.091257800826830257, 0.086774671894780178, 0.082338898242235656, 0.077950982513973394,
+    0.073611501884113403, 0.069321117393577908, 0.065080585213068073, 0.060890770348040406,
+    0.056752663481049848, 0.052667401903051012, 0.048636295859867805, 0.044660862200491425,
+    0.040742868074444175, 0.036884388786656203, 0.033087886146225751, 0.02935631744000685,
+    0.025693291935934271, 0.022103304615927098, 0.018592102737011288, 0.015167298010546568,
+    0.011839478657884862, 0.0086244844128598851, 0.0055489952207713449, 0.0026696290838809228
+};
+
+/** Exponential: accept directly below ke[i]. */
+static const unsigned int well1024_zig_ke[256] =
+{
+    0xe290a139U, 0x00000000U, 0x9beadebcU, 0xc377ac71U,
+    0xd4ddb990U, 0xde893fb8U, 0xe4a8e87cU, 0xe8dff16aU,
+    0xebf2deabU, 0xee49a6e8U, 0xf0204efdU, 0xf19bdb8eU,
+    0xf2d458bbU, 0xf3da104bU, 0xf4b86d78U, 0xf577ad8aU,
+    0xf61de83dU, 0xf6afb784U, 0xf730a573U, 0xf7a37651U,
+    0xf80a5bb6U, 0xf867189dU, 0xf8bb1b4fU, 0xf9079062U,
+    0xf94d70caU, 0xf98d8c7dU, 0xf9c8928aU, 0xf9ff175bU,
+    0xfa319996U, 0xfa6085f8U, 0xfa8c3a62U, 0xfab5084eU,
+    0xfadb36c8U, 0xfaff0410U, 0xfb20a6eaU, 0xfb404fb4U,
+    0xfb5e2951U, 0xfb7a59e9U, 0xfb95038cU, 0xfbae44baU,
+    0xfbc638d8U, 0xfbdcf892U, 0xfbf29a30U, 0xfc0731dfU,
+    0xfc1ad1edU, 0xfc2d8b02U, 0xfc3f6c4dU, 0xfc5083acU,
+    0xfc60ddd1U, 0xfc708662U, 0xfc7f8810U, 0xfc8decb4U,
+    0xfc9bbd62U, 0xfca9027cU, 0xfcb5c3c3U, 0xfcc20864U,
+    0xfccdd70aU, 0xfcd935e3U, 0xfce42ab0U, 0xfceebaceU,
+    0xfcf8eb3bU, 0xfd02c0a0U, 0xfd0c3f59U, 0xfd156b7bU,
+    0xfd1e48d6U, 0xfd26daffU, 0xfd2f2552U, 0xfd372af7U,
+    0xfd3eeee5U, 0xfd4673e7U, 0xfd4dbc9eU, 0xfd54cb85U,
+    0xfd5ba2f2U, 0xfd62451bU, 0xfd68b415U, 0xfd6ef1daU,
+    0xfd750047U, 0xfd7ae120U, 0xfd809612U, 0xfd8620b4U,
+    0xfd8b8285U, 0xfd90bcf5U, 0xfd95d15eU, 0xfd9ac10bU,
+    0xfd9f8d36U, 0xfda43708U, 0xfda8bf9eU, 0xfdad2806U,
+    0xfdb17141U, 0xfdb59c46U, 0xfdb9a9fdU, 0xfdbd9b46U,
+    0xfdc170f6U, 0xfdc52bd8U, 0xfdc8ccacU, 0xfdcc542dU,
+    0xfdcfc30bU, 0xfdd319efU, 0xfdd6597aU, 0xfdd98245U,
+    0xfddc94e5U, 0xfddf91e6U, 0xfde279ceU, 0xfde54d1fU,
+    0xfde80c52U, 0xfdeab7deU, 0xfded5034U, 0xfdefd5beU,
+    0xfdf248e3U, 0xfdf4aa06U, 0xfdf6f984U, 0xfdf937b6U,
+    0xfdfb64f4U, 0xfdfd818dU, 0xfdff8dd0U, 0xfe018a08U,
+    0xfe03767aU, 0xfe05536cU, 0xfe07211cU, 0xfe08dfc9U,
+    0xfe0a8fabU, 0xfe0c30fbU, 0xfe0dc3ecU, 0xfe0f48b1U,
+    0xfe10bf76U, 0xfe122869U, 0xfe1383b4U, 0xfe14d17cU,
+    0xfe1611e7U, 0xfe174516U, 0xfe186b2aU, 0xfe19843eU,
+    0xfe1a9070U, 0xfe1b8fd6U, 0xfe1c8289U, 0xfe1d689bU,
+    0xfe1e4220U, 0xfe1f0f26U, 0xfe1fcfbcU, 0xfe2083edU,
+    0xfe212bc3U, 0xfe21c745U, 0xfe225678U, 0xfe22d95fU,
+    0xfe234ffbU, 0xfe23ba4aU, 0xfe241849U, 0xfe2469f2U,
+    0xfe24af3cU, 0xfe24e81eU, 0xfe25148bU, 0xfe253474U,
+    0xfe2547c7U, 0xfe254e70U, 0xfe25485aU, 0xfe25356aU,
+    0xfe251586U, 0xfe24e88fU, 0xfe24ae64U, 0xfe2466e1U,
+    0xfe2411dfU, 0xfe23af34U, 0xfe233eb4U, 0xfe22c02cU,
+    0xfe22336bU, 0xfe219838U, 0xfe20ee58U, 0xfe20358cU,
+    0xfe1f6d92U, 0xfe1e9621U, 0xfe1daef0U, 0xfe1cb7acU,
+    0xfe1bb002U, 0xfe1a9798U, 0xfe196e0dU, 0xfe1832fdU,
+    0xfe16e5feU, 0xfe15869dU, 0xfe141464U, 0xfe128ed3U,
+    0xfe10f565U, 0xfe0f478cU, 0xfe0d84b1U, 0xfe0bac36U,
+    0xfe09bd73U, 0xfe07b7b5U, 0xfe059a40U, 0xfe03644cU,
+    0xfe011504U, 0xfdfeab88U, 0xfdfc26e9U, 0xfdf98629U,
+    0xfdf6c83bU, 0xfdf3ec01U, 0xfdf0f04aU, 0xfdedd3d1U,
+    0xfdea953dU, 0xfde7331eU, 0xfde3abe9U, 0xfddffdfbU,
+    0xfddc2791U, 0xfdd826cdU, 0xfdd3f9a8U, 0xfdcf9dfcU,
+    0xfdcb1176U, 0xfdc65198U, 0xfdc15bb3U, 0xfdbc2ce2U,
+    0xfdb6c206U, 0xfdb117beU, 0xfdab2a63U, 0xfda4f5fdU,
+    0xfd9e7640U, 0xfd97a67aU, 0xfd908192U, 0xfd8901f2U,
+    0xfd812182U, 0xfd78d98eU, 0xfd7022bbU, 0xfd66f4edU,
+    0xfd5d4732U, 0xfd530f9cU, 0xfd48432bU, 0xfd3cd59aU,
+    0xfd30b936U, 0xfd23dea4U, 0xfd16349eU, 0xfd07a7a3U,
+    0xfcf8219bU, 0xfce7895bU, 0xfcd5c220U, 0xfcc2aadbU,
+    0xfcae1d5eU, 0xfc97ed4eU, 0xfc7fe6d4U, 0xfc65ccf3U,
+    0xfc495762U, 0xfc2a2fc8U, 0xfc07ee19U, 0xfbe213c1U,
+    0xfbb8051aU, 0xfb890078U, 0xfb5411a5U, 0xfb180005U,
+    0xfad33482U, 0xfa839276U, 0xfa263b32U, 0xf9b72d1cU,
+    0xf930a1a2U, 0xf889f023U, 0xf7b577d2U, 0xf69c650cU,
+    0xf51530f0U, 0xf2cb0e3cU, 0xeeefb15dU, 0xe6da6ecfU
+};
+
+/** Exponential: width of layer i over 2^32. */
+static const double well1024_zig_we[256] =
+{
+    2.0249554585048198e-09, 1.4866740399734205e-11, 2.4409617196257019e-11, 3.1968807089142434e-11,
+    3.8446770646650347e-11, 4.4228203972434112e-11, 4.9516444707046597e-11, 5.4433588650931181e-11,
+    5.9059440015327192e-11, 6.3449420379115524e-11, 6.7643810876464267e-11, 7.1672944974835315e-11,
+    7.5560323199467426e-11, 7.9324580976935741e-11, 8.298078557904521e-11, 8.6541321438250886e-11,
+    9.0016512652187109e-11, 9.3415071930799696e-11, 9.6744431555352919e-11, 1.0001099208030049e-10,
+    1.0322031240760055e-10, 1.0637725725104457e-10, 1.0948611308870936e-10, 1.1255068044491511e-10,
+    1.1557434814019747e-10, 1.1856015362861798e-10, 1.2151083247552875e-10, 1.2442885926858554e-10,
+    1.2731648170466222e-10, 1.3017574919190648e-10, 1.3300853700670057e-10, 1.3581656682043475e-10,
+    1.3860142424039064e-10, 1.4136457387830522e-10, 1.4410737235911022e-10, 1.468310796035191e-10,
+    1.495368686561783e-10, 1.5222583428203639e-10, 1.548990005144558e-10, 1.5755732730718325e-10,
+    1.6020171641692171e-10, 1.6283301662263209e-10, 1.6545202837084708e-10, 1.6805950792244488e-10,
+    1.7065617106490835e-10, 1.7324269644462167e-10, 1.7581972856586329e-10, 1.7838788049654857e-10,
+    1.8094773631522604e-10, 1.8349985332914868e-10, 1.8604476408927817e-10, 1.8858297822471151e-10,
+    1.9111498411614671e-10, 1.9364125042554713e-10, 1.9616222749705577e-10, 1.986783486423947e-10,
+    2.0119003132241833e-10, 2.0369767823513203e-10, 2.0620167831931019e-10, 2.0870240768182279e-10,
+    2.112002304558848e-10, 2.136954995966615e-10, 2.1618855761997602e-10, 2.1867973728926396e-10,
+    2.2116936225538936e-10, 2.2365774765346773e-10, 2.2614520066042933e-10, 2.2863202101668828e-10,
+    2.3111850151495869e-10, 2.336049284589698e-10, 2.3609158209457405e-10, 2.3857873701551362e-10,
+    2.4106666254590428e-10, 2.4355562310131329e-10, 2.4604587853014233e-10, 2.4853768443687966e-10,
+    2.5103129248865199e-10, 2.5352695070638909e-10, 2.5602490374180384e-10, 2.5852539314129605e-10,
+    2.6102865759779895e-10, 2.6353493319150911e-10, 2.6604445362036835e-10, 2.6855745042110159e-10,
+    2.7107415318155595e-10, 2.735947897450323e-10, 2.7611958640725362e-10, 2.7864876810656891e-10,
+    2.8118255860795257e-10, 2.8372118068132283e-10, 2.8626485627466989e-10, 2.8881380668245368e-10,
+    2.9136825270970607e-10, 2.9392841483224504e-10, 2.9649451335338866e-10, 2.9906676855753434e-10,
+    3.0164540086095204e-10, 3.0423063096012276e-10, 3.0682267997793922e-10, 3.0942176960807172e-10,
+    3.120281222577913e-10, 3.1464196118953024e-10, 3.1726351066145236e-10, 3.1989299606729509e-10,
+    3.2253064407574023e-10, 3.2517668276956318e-10, 3.2783134178480468e-10, 3.3049485245020638e-10,
+    3.3316744792714682e-10, 3.3584936335031208e-10, 3.385408359693346e-10, 3.4124210529163118e-10,
+    3.4395341322667268e-10, 3.4667500423191701e-10, 3.4940712546063962e-10, 3.5215002691189675e-10,
+    3.5490396158286035e-10, 3.5766918562376672e-10, 3.6044595849572514e-10, 3.6323454313163818e-10,
+    3.6603520610049112e-10, 3.6884821777527412e-10, 3.7167385250480909e-10, 3.7451238878976035e-10,
+    3.7736410946311836e-10, 3.8022930187545505e-10, 3.8310825808526086e-10, 3.8600127505468491e-10,
+    3.8890865485101279e-10, 3.9183070485423172e-10, 3.9476773797104552e-10, 3.9772007285572071e-10,
+    4.0068803413816153e-10, 4.0367195265963012e-10, 4.0667216571654994e-10, 4.0968901731285145e-10,
+    4.1272285842134283e-10, 4.1577404725461407e-10, 4.1884294954601002e-10, 4.2192993884123649e-10,
+    4.2503539680119604e-10, 4.2815971351668243e-10, 4.3130328783559985e-10, 4.3446652770341104e-10,
+    4.3764985051756069e-10, 4.4085368349666444e-10, 4.4407846406530314e-10, 4.4732464025531173e-10,
+    4.5059267112450964e-10, 4.5388302719387827e-10, 4.5719619090425536e-10, 4.6053265709368553e-10,
+    4.6389293349664151e-10, 4.6727754126640966e-10, 4.7068701552202169e-10, 4.7412190592120656e-10,
+    4.7758277726093915e-10, 4.8107021010727083e-10, 4.8458480145624524e-10, 4.8812716542783108e-10,
+    4.9169793399494223e-10, 4.9529775774976463e-10, 4.9892730670977461e-10, 5.0258727116600781e-10,
+    5.0627836257633195e-10, 5.1000131450668475e-10, 5.1375688362346617e-10, 5.1754585074052172e-10,
+    5.2136902192442454e-10, 5.2522722966205807e-10, 5.2912133409482337e-10, 5.3305222432414786e-10,
+    5.3702081979335778e-10, 5.4102807175139843e-10, 5.4507496480435043e-10, 5.4916251856119817e-10,
+    5.5329178938086676e-10, 5.5746387222815783e-10, 5.6167990264689383e-10, 5.6594105885932732e-10,
+    5.7024856400169711e-10, 5.7460368850672781e-10, 5.7900775264487874e-10, 5.8346212923726911e-10,
+    5.8796824655445066e-10, 5.9252759141658261e-10, 5.9714171251210103e-10, 6.0181222395369397e-10,
+    6.0654080909230705e-10, 6.1132922461204966e-10, 6.1617930493126919e-10, 6.2109296693775583e-10,
+    6.2607221508906402e-10, 6.3111914691234304e-10, 6.3623595894191043e-10, 6.4142495313714003e-10,
+    6.4668854382814863e-10, 6.520292652423359e-10, 6.5744977967116044e-10, 6.6295288634374581e-10,
+    6.6854153108213581e-10, 6.7421881682242878e-10, 6.7998801509680825e-10, 6.8585257858388383e-10,
+    6.9181615484903926e-10, 6.9788260141297635e-10, 7.0405600230574674e-10, 7.1034068628574297e-10,
+    7.1674124692894912e-10, 7.2326256482392343e-10, 7.2990983214332897e-10, 7.3668857990437663e-10,
+    7.4360470827954072e-10, 7.5066452037689093e-10, 7.578747599782558e-10, 7.6524265380554776e-10,
+    7.7277595898386961e-10, 7.8048301648817006e-10, 7.8837281150284949e-10, 7.964550417966978e-10,
+    8.0474019542633808e-10, 8.1323963933951936e-10, 8.2196572076747075e-10, 8.3093188368909736e-10,
+    8.4015280313997575e-10, 8.4964454075341733e-10, 8.5942472569584664e-10, 8.6951276614326312e-10,
+    8.7993009770561058e-10, 8.9070047683137269e-10, 9.0185032933939347e-10, 9.1340916700090881e-10,
+    9.2541008877423724e-10, 9.3789038822240069e-10, 9.5089229531779803e-10, 9.6446388998629316e-10,
+    9.7866023744810505e-10, 9.9354481331011954e-10, 1.0091913119697238e-09, 1.0256859691519288e-09,
+    1.0431305846498463e-09, 1.0616465149697337e-09, 1.0813800351275404e-09, 1.1025096747562698e-09,
+    1.1252564706432517e-09, 1.1498986477733807e-09, 1.1767932423347028e-09, 1.2064090187897797e-09,
+    1.2393785886826128e-09, 1.2765849538906782e-09, 1.3193139264951723e-09, 1.3695434471116157e-09,
+    1.4305498138471953e-09, 1.5083650345524605e-09, 1.6160853275511056e-09, 1.7921248148501588e-09
+};
+
+/** Exponential: density at the edge of layer i. */
+static const double well1024_zig_fe[256] =
+{
+    1.0, 0.93814368086219635, 0.9004699299257618, 0.87170433238121592,
+    0.84778550062400004, 0.82699329664305943, 0.80842165152301648, 0.79152763697250306,
+    0.77595685204012244, 0.76146338884990261, 0.7478686219852011, 0.73503809243142915,
+    0.72286765959357735, 0.71127476080508101, 0.70019265508279294, 0.68956649611708254,
+    0.67935057226476969, 0.66950631673192884, 0.66000084107900359, 0.65080583341457476,
+    0.64189671642726964, 0.63325199421436951, 0.6248527387036692, 0.61668218091521076,
+    0.60872538207962512, 0.60096896636523522, 0.59340090169173632, 0.58601031847727081,
+    0.57878735860284769, 0.57172304866482837, 0.56480919291240272, 0.55803828226258989,
+    0.55140341654064362, 0.54489823767244183, 0.53851687200286402, 0.53225388026304532,
+    0.52610421398362173, 0.52006317736823549, 0.51412639381475045, 0.50828977641064466,
+    0.5025495018413495, 0.49690198724155127, 0.4913438695940342, 0.48587198734188652,
+    0.48048336393045576, 0.47517519303737887, 0.46994482528396148, 0.46478975625042762,
+    0.45970761564213908, 0.45469615747461684, 0.44975325116275633, 0.44487687341454984,
+    0.44006510084235517, 0.43531610321563785, 0.43062813728846006, 0.42599954114303556,
+    0.4214287289976178, 0.41691418643300404, 0.41245446599716229, 0.40804818315203345,
+    0.40369401253053133, 0.39939068447523213, 0.39513698183329116, 0.39093173698479811,
+    0.38677382908413865, 0.38266218149601078, 0.37859575940958173, 0.37457356761590305,
+    0.37059464843514689, 0.36665807978151504, 0.36276297335481866, 0.35890847294875056,
+    0.35509375286678818, 0.351318016437484, 0.34758049462163765, 0.34388044470450307,
+    0.34021714906678069, 0.33658991402867827, 0.33299806876180965, 0.32944096426413705,
+    0.32591797239355691, 0.32242848495608983, 0.31897191284495791, 0.31554768522712956,
+    0.31215524877418016, 0.30879406693456074, 0.30546361924459081, 0.30216340067569408,
+    0.29889292101558229, 0.2956517042812617, 0.29243928816189307, 0.28925522348967819,
+    0.28609907373707727, 0.28297041453878119, 0.27986883323697331, 0.27679392844851775,
+    0.27374530965280336, 0.27072259679906047, 0.26772541993204524, 0.26475341883506259,
+    0.26180624268936331, 0.25888354974901656, 0.25598500703041571, 0.25311029001562979,
+    0.25025908236886263, 0.24743107566532793, 0.24462596913189236, 0.24184346939887746,
+    0.23908329026244937, 0.23634515245705984, 0.23362878343743348, 0.23093391716962755,
+    0.22826029393071681, 0.22560766011668415, 0.22297576805812028, 0.22036437584335958,
+    0.21777324714870061, 0.21520215107537877, 0.21265086199297836, 0.21011915938898837,
+    0.20760682772422212, 0.20511365629383779, 0.2026394390937091, 0.20018397469191135,
+    0.19774706610509893, 0.19532852067956327, 0.19292814997677141, 0.19054576966319545,
+    0.18818119940425435, 0.18583426276219714, 0.18350478709776744, 0.18119260347549626,
+    0.17889754657247828, 0.17661945459049483, 0.17435816917135341, 0.17211353531531998,
+    0.16988540130252755, 0.16767361861725008, 0.16547804187493589, 0.16329852875190168,
+    0.1611349399175919, 0.15898713896931407, 0.15685499236936509, 0.15473836938446794,
+    0.15263714202744272, 0.15055118500103976, 0.14848037564386662, 0.14642459387834475,
+    0.14438372216063458, 0.14235764543247201, 0.14034625107486226, 0.13834942886358001,
+    0.13636707092642864, 0.13439907170221341, 0.13244532790138733, 0.13050573846833061,
+    0.12858020454522801, 0.1266686294375105, 0.12477091858083077, 0.12288697950954494,
+    0.12101672182667463, 0.11916005717532749, 0.11731689921155537, 0.11548716357863334,
+    0.11367076788274413, 0.11186763167005613, 0.11007767640518522, 0.1083008254510336,
+    0.10653700405000148, 0.10478613930657001, 0.10304816017125756, 0.10132299742595349,
+    0.099610583670637007, 0.097910853311492074, 0.096223742550432659, 0.094549189376055692,
+    0.092887133556043361, 0.091237516631039961, 0.089600281910032678, 0.087975374467270037,
+    0.086362741140756732, 0.084762330532367952, 0.083174093009632216, 0.081597980709237239,
+    0.080033947542319725, 0.078481949201606227, 0.076941943170480309, 0.075413888734058201,
+    0.073897746992364552, 0.07239348087570853, 0.070901055162371593, 0.069420436498728505,
+    0.067951593421936365, 0.066494496385339552, 0.065049117786753541, 0.063615431999807098,
+    0.062193415408540759, 0.06078304644547939, 0.059384305633420016, 0.057997175631200402,
+    0.05662164128374262, 0.055257689676696788, 0.053905310196045816, 0.052564494593071408,
+    0.051235237055125983, 0.049917534282706066, 0.048611385573379198, 0.047316792913181249,
+    0.046033761076174871, 0.044762297732942991, 0.043502413568887892, 0.042254122413315935,
+    0.041017441380414528, 0.03979239102337382, 0.038578995503074545, 0.037377282772959049,
+    0.03618728478193111, 0.035009037697397091, 0.033842582150874011, 0.032687963508959222,
+    0.031545232172893289, 0.030414443910466285, 0.029295660224637071, 0.028188948763978306,
+    0.027094383780955467, 0.026012046645133884, 0.024942026419731454, 0.023884420511557845,
+    0.022839335406384914, 0.021806887504283261, 0.020787204072577802, 0.019780424338009424,
+    0.018786700744695708, 0.017806200410911039, 0.016839106826039625, 0.015885621839972847,
+    0.014945968011690829, 0.014020391403181618, 0.013109164931254677, 0.012212592426255064,
+    0.011331013597834288, 0.010464810181029675, 0.0096144136425019046, 0.0087803149858086734,
+    0.0079630774380167399, 0.0071633531836346855, 0.0063819059373188833, 0.005619642207205189,
+    0.0048776559835421052, 0.0041572951208335126, 0.0034602647778366304, 0.0027887987935738107,
+    0.0021459677437186517, 0.0015362997803013297, 0.00096726928232694837, 0.00045413435384129814
+};
+
+/** Return a double in the (0, 1) range (never 0, for logarithms). */
+double well1024_next_double_open(well1024 *rng)
+{
+    return ((double)well1024_next_uint32(rng) + 0.5) * 2.32830643653869628906e-10;
+}
+
+/** Return a double following the standard normal distribution, with the ziggurat method. */
+double well1024_next_normal_zig(well1024 *rng)
+{
+    while (TRUE)
+    {
+        const int hz = (int)well1024_next_uint32(rng);
+        const unsigned int iz = (unsigned int)hz & 127;
+        const int64_t ahz = (hz < 0) ? -(int64_t)hz : (int64_t)hz;
+        const double x = hz * well1024_zig_wn[iz];
+        if (ahz < (int64_t)well1024_zig_kn[iz])
+        {
+            return x; // 99% of the draws.
+        }
+        if (iz == 0)
+        {
+            // The tail, beyond r = 3.442620.
+            double xt, y;
+            do
+            {
+                xt = -log(well1024_next_double_open(rng)) * 0.2904764;
+                y = -log(well1024_next_double_open(rng));
+            }
+            while (y + y < xt * xt);
+            return (hz > 0) ? 3.442620 + xt : -3.442620 - xt;
+        }
+        if (well1024_zig_fn[iz] + well1024_next_double(rng) * (well1024_zig_fn[iz - 1] - well1024_zig_fn[iz]) < exp(-0.5 * x * x))
+        {
+            return x;
+        }
+    }
+}
+
+/** Return a double following the exponential distribution (rate 1), with the ziggurat method. */
+double well1024_next_exp_zig(well1024 *rng)
+{
+    double base = 0.0;
+    while (TRUE)
+    {
+        const unsigned int jz = well1024_next_uint32(rng);
+        const unsigned int iz = jz & 255;
+        const double x = jz * well1024_zig_we[iz];
+        if (jz < well1024_zig_ke[iz])
+        {
+            return base + x; // 99% of the draws.
+        }
+        if (iz == 0)
+        {
+            // The tail is the distribution shifted by r = 7.69711.
+            base += 7.69711747013104972;
+            continue;
+        }
+        if (well1024_zig_fe[iz] + well1024_next_double(rng) * (well1024_zig_fe[iz - 1] - well1024_zig_fe[iz]) < exp(-x))
+        {
+            return base + x;
+        }
+    }
+}
+
+/** Fill an array with standard normal numbers (ziggurat method). */
+void well1024_fill_normal(well1024 *rng, double *dst, size_t n)
+{
+    size_t i = 0;
+    for (; i < n; ++i)
+    {
+        dst[i] = well1024_next_normal_zig(rng);
+    }
+}
+
+/** Fill an array with exponential numbers of rate 1 (ziggurat method). */
+void well1024_fill_exp(well1024 *rng, double *dst, size_t n)
+{
+    size_t i = 0;
+    for (; i < n; ++i)
+    {
+        dst[i] = well1024_next_exp_zig(rng);
+    }
+}
+
+/** Poisson by multiplication of uniforms (Knuth), for small lambda. \f$O(\lambda)\f$. */
+int well1024_next_poisson_mult(well1024 *rng, double lambda)
 {
     const double l = pow(2.71828182845904523536, -lambda);
     double p = 1.0;
@@ -180,6 +923,219 @@ int well1024_next_poisson(well1024 *rng, double lambda)
     return k - 1;
 }
 
+/** Poisson by transformed rejection with squeeze (Hormann's PTRS), for lambda >= 10. \f$O(1)\f$ expected. */
+int well1024_next_poisson_ptrs(well1024 *rng, double lambda)
+{
+    const double slam = sqrt(lambda);
+    const double loglam = log(lambda);
+    const double b = 0.931 + 2.53 * slam;
+    const double a = -0.059 + 0.02483 * b;
+    const double invalpha = 1.1239 + 1.1328 / (b - 3.4);
+    const double vr = 0.9277 - 3.6224 / (b - 2);
+
+    while (TRUE)
+    {
+        const double u = well1024_next_double(rng) - 0.5;
+        const double v = well1024_next_double(rng);
+        const double us = 0.5 - fabs(u);
+        const double k = floor((2 * a / us + b) * u + lambda + 0.43);
+        if (us >= 0.07 && v <= vr)
+        {
+            return (int)k;
+        }
+        if (k < 0 || (us < 0.013 && v > us) || v == 0.0)
+        {
+            continue;
+        }
+        if (log(v) + log(invalpha) - log(a / (us * us) + b) <= -lambda + k * loglam - lgamma(k + 1))
+        {
+            return (int)k;
+        }
+    }
+}
+
+/** Return an integer from a poisson distribution given lambda. \f$O(1)\f$ expected (multiplication below 10, PTRS above). */
+int well1024_next_poisson(well1024 *rng, double lambda)
+{
+    return (lambda < 10.0) ? well1024_next_poisson_mult(rng, lambda) : well1024_next_poisson_ptrs(rng, lambda);
+}
+
+/** Correction term of Stirling's approximation: log(k!) - (k + 1/2) log(k + 1) + (k + 1) - log(2 pi) / 2. */
+double well1024_fc(int k)
+{
+    static const double table[10] =
+    {
+        0.08106146679532726, 0.04134069595540929, 0.02767792568499834, 0.02079067210376509,
+        0.01664469118982119, 0.01387612882307075, 0.01189670994589177, 0.01041126526197209,
+        0.009255462182712733, 0.008330563433362871
+    };
+    if (k < 10)
+    {
+        return table[k];
+    }
+    const double ikp1 = 1.0 / (k + 1);
+    return (1.0 / 12 - (1.0 / 360 - ikp1 * ikp1 / 1260) * ikp1 * ikp1) * ikp1;
+}
+
+/** Binomial by inversion (sequential search from 0), for small n * p. \f$O(np)\f$. */
+int well1024_next_binomial_inv(well1024 *rng, int n, double p)
+{
+    const double q = 1.0 - p;
+    const double s = p / q;
+    const double a = (n + 1) * s;
+    while (TRUE)
+    {
+        double r = pow(q, n);
+        double u = well1024_next_double(rng);
+        int x = 0;
+        while (u > r)
+        {
+            u -= r;
+            ++x;
+            if (x > n)
+            {
+                break; // Rounding errors, try again.
+            }
+            r *= a / x - s;
+        }
+        if (x <= n)
+        {
+            return x;
+        }
+    }
+}
+
+/** Binomial by transformed rejection with decomposition (Hormann's BTRD), for p <= 0.5 and (n + 1) p >= 11. \f$O(1)\f$ expected. */
+int well1024_next_binomial_btrd(well1024 *rng, int n, double p)
+{
+    const int m = (int)floor((n + 1) * p);
+    const double r = p / (1.0 - p);
+    const double nr = (n + 1) * r;
+    const double npq = n * p * (1.0 - p);
+    const double sqrt_npq = sqrt(npq);
+    const double b = 1.15 + 2.53 * sqrt_npq;
+    const double a = -0.0873 + 0.0248 * b + 0.01 * p;
+    const double c = n * p + 0.5;
+    const double alpha = (2.83 + 5.1 / b) * sqrt_npq;
+    const double v_r = 0.92 - 4.2 / b;
+    const double u_rv_r = 0.86 * v_r;
+
+    while (TRUE)
+    {
+        double u;
+        double v = well1024_next_double(rng);
+        if (v <= u_rv_r)
+        {
+            u = v / v_r - 0.43;
+            return (int)floor((2 * a / (0.5 - fabs(u)) + b) * u + c);
+        }
+        if (v >= v_r)
+        {
+            u = well1024_next_double(rng) - 0.5;
+        }
+        else
+        {
+            u = v / v_r - 0.93;
+            u = ((u < 0) ? -0.5 : 0.5) - u;
+            v = well1024_next_double(rng) * v_r;
+        }
+        const double us = 0.5 - fabs(u);
+        const double kd = floor((2 * a / us + b) * u + c);
+        if (kd < 0 || kd > n)
+        {
+            continue;
+        }
+        const int k = (int)kd;
+        v = v * alpha / (a / (us * us) + b);
+        const int km = (k > m) ? k - m : m - k;
+        if (km <= 15)
+        {
+            // Recursive evaluation of f(k) / f(m).
+            double f = 1.0;
+            int i;
+            if (m < k)
+            {
+                for (i = m + 1; i <= k; ++i)
+                {
+                    f *= nr / i - r;
+                }
+            }
+            else if (m > k)
+            {
+                for (i = k + 1; i <= m; ++i)
+                {
+                    v *= nr / i - r;
+                }
+            }
+            if (v <= f)
+            {
+                return k;
+            }
+        }
+        else
+        {
+            // Squeeze with the normal approximation, then the exact test with Stirling's formula.
+            v = log(v);
+            const double rho = (km / npq) * (((km / 3.0 + 0.625) * km + 1.0 / 6) / npq + 0.5);
+            const double t = -(double)km * km / (2 * npq);
+            if (v < t - rho)
+            {
+                return k;
+            }
+            if (v > t + rho)
+            {
+                continue;
+            }
+            const double nm = n - m + 1;
+            const double h = (m + 0.5) * log((m + 1) / (r * nm)) + well1024_fc(m) + well1024_fc(n - m);
+            const double nk = n - k + 1;
+            if (v <= h + (n + 1) * log(nm / nk) + (k + 0.5) * log(nk * r / (k + 1)) - well1024_fc(k) - well1024_fc(n - k))
+            {
+                return k;
+            }
+        }
+    }
+}
+
+/** Return an integer from a binomial distribution (n trials, probability p). \f$O(1)\f$ expected (inversion for small means, BTRD otherwise). */
+int well1024_next_binomial(well1024 *rng, int n, double p)
+{
+    assert(n >= 0 && p >= 0.0 && p <= 1.0);
+    if (p > 0.5)
+    {
+        return n - well1024_next_binomial(rng, n, 1.0 - p);
+    }
+    if (n == 0 || p == 0.0)
+    {
+        return 0;
+    }
+    return ((n + 1) * p < 11.0) ? well1024_next_binomial_inv(rng, n, p) : well1024_next_binomial_btrd(rng, n, p);
+}
+
+/** Number of failures before the first success of Bernoulli trials of probability p, \f$O(1)\f$ (UINT64_MAX if p is 0). */
+uint64_t well1024_next_geometric(well1024 *rng, double p)
+{
+    assert(p >= 0.0 && p <= 1.0);
+    if (p == 1.0)
+    {
+        return 0;
+    }
+    if (p == 0.0)
+    {
+        return UINT64_MAX;
+    }
+    const double g = floor(log(well1024_next_double_open(rng)) / log1p(-p));
+    return (g >= 18446744073709551615.0) ? UINT64_MAX : (uint64_t)g;
+}
+
+/** Next site hit at or after pos, each site being hit with probability p (skips the sites in between).
+ *  Visiting the n hits of a sequence of length L costs O(n), not O(L):
+ *  for (i = well1024_next_site(rng, 0, p); i < L; i = well1024_next_site(rng, i + 1, p)) */
+uint64_t well1024_next_site(well1024 *rng, uint64_t pos, double p)
+{
+    const uint64_t skip = well1024_next_geometric(rng, p);
+    return (skip > UINT64_MAX - pos) ? UINT64_MAX : pos + skip;
+}
 
 // UTILS
 
@@ -0,0 +1,106 @@
+/**
+ * This file contains tests and examples for the validation and the compaction
+ * of sequences: the SSE2/SSSE3 paths are checked against a residue by residue
+ * loop, in place and into another buffer.
+ *
+ * Compiling
+ * ---------
+ * gcc -Wall -O3 -mssse3 -I../devries -o example-compact example-compact.c $(xml2-config --libs) $(xml2-config --cflags) -lm -lz -pthread
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "seq.h"
+
+/* TRUE if c is 'A', 'C', 'G' or last. */
+int is_nuc(char c, char last)
+{
+    return c == 'A' || c == 'C' || c == 'G' || c == last;
+}
+
+int main()
+{
+    well1024 rng;
+    well1024_init(&rng, 42);
+
+    static const char *valid[2] = {"ACGT", "ACGU"};
+    static const char *invalid = "NRYacgtuU-*\n\r \x80\xff";
+    const size_t size = 5000;
+    char *seq = (char*)malloc(size);
+    char *dst = (char*)malloc(size);
+    char *expected = (char*)malloc(size);
+    uint64_t histogram[256], expected_histogram[256];
+    unsigned int errors = 0, tests = 0;
+
+    /* Every density of invalid residues (none, a few, half, all), every length
+       around the 16-residue blocks and both alphabets: */
+    static const int density[4] = {0, 10, 500, 1000};
+    unsigned int d = 0;
+    for (; d < 4; ++d)
+    {
+        size_t length = 0;
+        for (; length < size; length += (length < 100) ? 1 : 89)
+        {
+            const int rna = (int)well1024_next_int(&rng, 2);
+            const char last = rna ? 'U' : 'T';
+            size_t i = 0;
+            for (; i < length; ++i)
+            {
+                seq[i] = (well1024_next_int(&rng, 1000) < density[d]) ?
+                    invalid[well1024_next_int(&rng, (unsigned int)strlen(invalid))] :
+                    valid[rna][well1024_next_int(&rng, 4)];
+            }
+
+            /* Residue by residue: */
+            size_t first = length, count = 0;
+            memset(expected_histogram, 0, sizeof(expected_histogram));
+            for (i = 0; i < length; ++i)
+            {
+                if (is_nuc(seq[i], last))
+                {
+                    expected[count++] = seq[i];
+                }
+                else
+                {
+                    first = (first == length) ? i : first;
+                    ++expected_histogram[(unsigned char)seq[i]];
+                }
+            }
+
+            /* Validation, with and without the histogram: */
+            int ok = (nuc_validate_n(seq, length, last, NULL) == first);
+            memset(histogram, 0, sizeof(histogram));
+            ok = ok && (nuc_validate_n(seq, length, last, histogram) == first);
+            ok = ok && (memcmp(histogram, expected_histogram, sizeof(histogram)) == 0);
+
+            /* Compaction into another buffer, then in place: */
+            ok = ok && (nuc_compact_n(seq, length, last, dst) == count);
+            ok = ok && (memcmp(dst, expected, count) == 0);
+            ok = ok && (nuc_compact_n(seq, length, last, seq) == count);
+            ok = ok && (memcmp(seq, expected, count) == 0);
+
+            errors += !ok;
+            ++tests;
+        }
+    }
+    printf("nuc_validate_n and nuc_compact_n: %u error(s) in %u test(s)\n", errors, tests);
+
+    /* The string functions built on them: */
+    char with_amb[] = "ACGTNNACGTRYACGTACGTACGTACGTACGTACGTACGTACGTNACGT";
+    char *dna = dna_rmv_amb(with_amb);
+    const int string_ok = !dna_pure_seq(with_amb) && dna_pure_seq(dna) &&
+                          strcmp(dna, "ACGTACGTACGTACGTACGTACGTACGTACGTACGTACGTACGT") == 0;
+    if (!string_ok)
+    {
+        printf("error: dna_rmv_amb gave %s\n", dna);
+    }
+    free(dna);
+    printf("%s\n", (errors == 0 && string_ok) ? "ok" : "error");
+
+    free(expected);
+    free(dst);
+    free(seq);
+
+    return (errors == 0 && string_ok) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,149 @@
+/**
+ * This file contains tests and examples for the base composition: the SSE2 and
+ * AVX2 counts are checked against a residue by residue count, and the sliding
+ * windows against the composition of each window.
+ *
+ * Compiling
+ * ---------
+ * gcc -Wall -O3 -mavx2 -I../devries -o example-composition example-composition.c $(xml2-config --libs) $(xml2-config --cflags) -lm -lz -pthread
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "seq.h"
+
+/* Residue by residue composition. */
+void naive_composition(const char *seq, size_t length, composition *comp)
+{
+    memset(comp, 0, sizeof(composition));
+    size_t i = 0;
+    for (; i < length; ++i)
+    {
+        switch (seq[i])
+        {
+            case 'A': ++comp->a; break;
+            case 'C': ++comp->c; break;
+            case 'G': ++comp->g; break;
+            case 'T': ++comp->t; break;
+            case 'U': ++comp->u; break;
+            case 'N': ++comp->n; break;
+            default: ++comp->other; break;
+        }
+    }
+}
+
+/* TRUE if two compositions are the same. */
+int same_composition(const composition *x, const composition *y)
+{
+    return x->a == y->a && x->c == y->c && x->g == y->g && x->t == y->t &&
+           x->u == y->u && x->n == y->n && x->other == y->other;
+}
+
+/* Windows seen by a window_profile. */
+typedef struct
+{
+    composition *windows;
+
+    uint64_t n;
+
+    unsigned int step;
+
+    unsigned int errors;
+}
+profile_data;
+
+/* Called for each window of a window_profile. */
+void check_window(uint64_t start, const composition *comp, void *data)
+{
+    profile_data *d = (profile_data*)data;
+    if (start != d->n * d->step || !same_composition(comp, &d->windows[d->n]))
+    {
+        ++d->errors;
+    }
+    ++d->n;
+}
+
+int main()
+{
+    well1024 rng;
+    well1024_init(&rng, 42);
+
+    /* Mostly nucleotides, with lowercase and other bytes, long enough for the
+       8-bit counters to be flushed several times: */
+    static const char *residues = "ACGTUNacgtn-X\n\xff";
+    const size_t size = 100000;
+    char *seq = (char*)malloc(size);
+    size_t i = 0;
+    for (; i < size; ++i)
+    {
+        seq[i] = residues[well1024_next_int(&rng, 4) ? well1024_next_int(&rng, 6) : well1024_next_int(&rng, 15)];
+    }
+
+    /* Every length around the 16 and 32-residue blocks, from every offset: */
+    composition comp, expected;
+    unsigned int errors = 0, tests = 0;
+    size_t length = 0;
+    for (; length <= size; length += (length < 300) ? 1 : 997)
+    {
+        const size_t offset = well1024_next_int(&rng, 32);
+        const size_t n = (offset + length > size) ? size - offset : length;
+        seq_composition_n(seq + offset, n, &comp);
+        naive_composition(seq + offset, n, &expected);
+        errors += !same_composition(&comp, &expected);
+        ++tests;
+    }
+    printf("seq_composition_n: %u error(s) in %u test(s)\n", errors, tests);
+
+    /* Sliding windows against the composition of each window, and fed in chunks: */
+    static const unsigned int sizes[4][2] = {{1, 1}, {17, 5}, {100, 100}, {1000, 7}};
+    const size_t profile_length = 20000;
+    unsigned int window_errors = 0;
+    for (i = 0; i < 4; ++i)
+    {
+        const unsigned int window = sizes[i][0], step = sizes[i][1];
+        uint64_t nwindows = 0;
+        composition *windows = seq_windows(seq, profile_length, window, step, &nwindows);
+        uint64_t w = 0;
+        for (; w < nwindows; ++w)
+        {
+            naive_composition(seq + w * step, window, &expected);
+            window_errors += !same_composition(&windows[w], &expected);
+        }
+        window_errors += (nwindows != (profile_length - window) / step + 1);
+
+        profile_data d;
+        d.windows = windows;
+        d.n = 0;
+        d.step = step;
+        d.errors = 0;
+        window_profile wp;
+        window_profile_init(&wp, window, step, check_window, &d);
+        size_t pos = 0;
+        while (pos < profile_length)
+        {
+            size_t chunk = 1 + well1024_next_int(&rng, 2 * window);
+            chunk = (pos + chunk > profile_length) ? profile_length - pos : chunk;
+            window_profile_feed(&wp, seq + pos, chunk);
+            pos += chunk;
+        }
+        window_profile_free(&wp);
+        window_errors += d.errors + (d.n != nwindows);
+        free(windows);
+    }
+    printf("seq_windows and window_profile: %u error(s)\n", window_errors);
+
+    /* The string functions built on it: */
+    const char *dna = "ACGTGGCCNNacgt";
+    const int string_ok = (gc_count(dna) == 6) && (gc_content(dna) == 6.0 / 14.0);
+    if (!string_ok)
+    {
+        printf("error: %u G or C in %s\n", gc_count(dna), dna);
+    }
+    const int ok = (errors == 0) && (window_errors == 0) && string_ok;
+    printf("%s\n", ok ? "ok" : "error");
+
+    free(seq);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
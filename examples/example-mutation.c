@@ -0,0 +1,102 @@
+/**
+ * This file contains tests and examples for the mutation trees: the sequences
+ * of the leaves are built in one walk, and checked against the other ways to
+ * build the sequence of a node.
+ *
+ * Compiling
+ * ---------
+ * gcc -Wall -O3 -I../devries -o example-mutation example-mutation.c $(xml2-config --libs) $(xml2-config --cflags) -lm -lz -pthread
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mutation.h"
+#include "well1024.h"
+
+typedef struct
+{
+    const mutation_tree *mt;
+
+    mutation_cache *cache;
+
+    unsigned int errors;
+}
+check_data;
+
+/* Called for every leaf with its sequence. */
+void check_leaf(const tnode *leaf, const char *seq, size_t length, void *data)
+{
+    check_data *d = (check_data*)data;
+    tnode *node = (tnode*)leaf;
+
+    /* From the root, on a rope: */
+    char *from_root = get_sequence(d->mt, node);
+
+    /* All the mutations from the root, in one batch: */
+    sll *l = list_mutations(node);
+    char *from_list = apply_mut_list(d->mt->seq, l);
+    sll_free(l);
+    free(l);
+
+    /* From the nearest cached ancestor: */
+    char *from_cache = mutation_cache_get(d->cache, node);
+
+    if (strlen(seq) != length || strcmp(seq, from_root) != 0 || strcmp(seq, from_list) != 0 || strcmp(seq, from_cache) != 0)
+    {
+        ++d->errors;
+    }
+    free(from_root);
+    free(from_list);
+    free(from_cache);
+}
+
+int main()
+{
+    well1024 rng;
+    well1024_init(&rng, 42);
+
+    /* A random tree of 1000 nodes (the names are not copied): */
+    char root_name[] = "root";
+    char node_name[] = "node";
+    tnode *nodes[1000];
+    nodes[0] = tnode_init(NULL, root_name, NULL);
+    unsigned int i = 1;
+    for (; i < 1000; ++i)
+    {
+        tnode *p = nodes[well1024_next_int(&rng, i)];
+        nodes[i] = tnode_init(p, node_name, NULL);
+        nodes[i]->length = 0.1 * well1024_next_double(&rng);
+        tnode_add_children(p, nodes[i]);
+    }
+
+    /* Evolve a random sequence along the tree: */
+    mutation_tree mt;
+    mt.seq = dna_random_nuc_seq(&rng, 5000);
+    mt.root = nodes[0];
+    mutation_rates rates;
+    rates.point = 0.05;
+    rates.insertion = 0.01;
+    rates.deletion = 0.01;
+    rates.ins_extend = 0.5;
+    rates.del_extend = 0.5;
+    const uint64_t nmuts = mutation_tree_simulate(&mt, &rates, &rng);
+    printf("%lu mutation(s) on %u edge(s)\n", (unsigned long)nmuts, tnode_nedges(mt.root));
+
+    /* Build all the leaves in one walk, and check each of them: */
+    mutation_cache cache;
+    mutation_cache_init(&cache, &mt, CacheFrequency, 0, 1 << 20, TRUE);
+    check_data d;
+    d.mt = &mt;
+    d.cache = &cache;
+    d.errors = 0;
+    const uint64_t nleaves = mutation_tree_leaves(&mt, check_leaf, &d);
+    printf("%lu leaves, %u error(s), cache: %lu hit(s), %lu miss(es)\n", (unsigned long)nleaves, d.errors, (unsigned long)cache.hits, (unsigned long)cache.misses);
+
+    mutation_cache_free(&cache);
+    mutation_tree_clear(&mt);
+    tnode_free(mt.root);
+    free(mt.seq);
+
+    return (d.errors == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,231 @@
+/**
+ * This file contains tests and examples for the translation and the six-frame
+ * ORF scanner: the table-driven (and SSSE3) paths are checked against a codon
+ * by codon translation and a frame by frame search.
+ *
+ * Compiling
+ * ---------
+ * gcc -Wall -O3 -mssse3 -I../devries -o example-orf example-orf.c $(xml2-config --libs) $(xml2-config --cflags) -lm -lz -pthread
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "seq.h"
+
+/* Index of a nucleotide in a codon (A:0, C:1, G:2, T/U:3), -1 for the others. */
+int nuc_index(char c)
+{
+    switch (c)
+    {
+        case 'A': case 'a': return 0;
+        case 'C': case 'c': return 1;
+        case 'G': case 'g': return 2;
+        case 'T': case 't': case 'U': case 'u': return 3;
+        default: return -1;
+    }
+}
+
+/* Index of the codon at seq[p] on a strand, -1 if it has another residue. */
+int codon_index(const char *seq, size_t p, int strand)
+{
+    const int n1 = nuc_index(seq[p]);
+    const int n2 = nuc_index(seq[p + 1]);
+    const int n3 = nuc_index(seq[p + 2]);
+    if (n1 < 0 || n2 < 0 || n3 < 0)
+    {
+        return -1;
+    }
+    return (strand > 0) ? 16 * n1 + 4 * n2 + n3 : 16 * (3 - n3) + 4 * (3 - n2) + (3 - n1);
+}
+
+/* Frame by frame search, with the rules of orf_scanner. */
+size_t naive_orfs(const char *seq, size_t length, const genetic_code *code, unsigned int min_codons, orf *orfs)
+{
+    size_t n = 0;
+    size_t frame = 0;
+    for (; frame < 3; ++frame)
+    {
+        int64_t fwd_start = -1, rev_stop = -1, rev_start = -1;
+        size_t p = frame;
+        for (; p + 3 <= length; p += 3)
+        {
+            const int f = codon_index(seq, p, 1);
+            const int r = codon_index(seq, p, -1);
+            if (f >= 0 && code->table[f] == 'Z' && fwd_start >= 0)
+            {
+                if ((p + 3 - fwd_start) / 3 - 1 >= min_codons)
+                {
+                    orfs[n].begin = fwd_start; orfs[n].end = p + 3; orfs[n++].strand = 1;
+                }
+                fwd_start = -1;
+            }
+            else if (f >= 0 && code->start[f] && fwd_start < 0)
+            {
+                fwd_start = p;
+            }
+            if (r >= 0 && code->table[r] == 'Z')
+            {
+                if (rev_start >= 0 && (rev_start + 3 - rev_stop) / 3 - 1 >= min_codons)
+                {
+                    orfs[n].begin = rev_stop; orfs[n].end = rev_start + 3; orfs[n++].strand = -1;
+                }
+                rev_stop = p;
+                rev_start = -1;
+            }
+            else if (r >= 0 && code->start[r] && rev_stop >= 0)
+            {
+                rev_start = p;
+            }
+        }
+        if (rev_start >= 0 && (rev_start + 3 - rev_stop) / 3 - 1 >= min_codons)
+        {
+            orfs[n].begin = rev_stop; orfs[n].end = rev_start + 3; orfs[n++].strand = -1;
+        }
+    }
+    return n;
+}
+
+/* Order of the ORFs for the comparison. */
+int orf_cmp(const void *a, const void *b)
+{
+    const orf *x = (const orf*)a;
+    const orf *y = (const orf*)b;
+    if (x->begin != y->begin)
+    {
+        return (x->begin < y->begin) ? -1 : 1;
+    }
+    if (x->end != y->end)
+    {
+        return (x->end < y->end) ? -1 : 1;
+    }
+    return x->strand - y->strand;
+}
+
+/* TRUE if two sorted lists of ORFs are the same. */
+int same_orfs(const orf *a, size_t na, const orf *b, size_t nb)
+{
+    size_t i = 0;
+    for (; i < na && i < nb && orf_cmp(a + i, b + i) == 0; ++i);
+    return (na == nb && i == na);
+}
+
+int main()
+{
+    well1024 rng;
+    well1024_init(&rng, 42);
+
+    /* A random sequence with a few runs of N: */
+    const size_t length = 200000;
+    char *seq = dna_random_nuc_seq(&rng, (unsigned int)length);
+    unsigned int i = 0;
+    for (; i < 200; ++i)
+    {
+        const size_t pos = well1024_next_int(&rng, (unsigned int)length - 10);
+        memset(seq + pos, 'N', 1 + well1024_next_int(&rng, 8));
+    }
+    int ok = TRUE;
+
+    /* Table-driven translation against one codon at a time, on every reading
+       frame and in lower case: */
+    genetic_code code;
+    genetic_code_init(&code, 1);
+    char *lower = (char*)malloc(length + 1);
+    for (i = 0; i < length; ++i)
+    {
+        lower[i] = (char)tolower((unsigned char)seq[i]);
+    }
+    lower[length] = '\0';
+    char *amino = (char*)malloc(length / 3 + 1);
+    unsigned int frame = 0;
+    for (; frame < 3; ++frame)
+    {
+        const char *s = (frame == 0) ? lower : seq + frame;
+        const size_t n_amino = translate_n(s, length - frame, code.table, amino);
+        size_t a = 0;
+        for (; a < n_amino && amino[a] == translate_codon(s + 3 * a, code.table); ++a);
+        if (n_amino != (length - frame) / 3 || a != n_amino || amino[n_amino] != '\0')
+        {
+            printf("error: translate_n differs from translate_codon at codon %lu (frame %u)\n", (unsigned long)a, frame);
+            ok = FALSE;
+        }
+    }
+
+    /* The compressed sequence gives the same proteins: */
+    cseq cs;
+    cseq_pack(&cs, seq, (unsigned int)length);
+    char *cs_amino = (char*)malloc(length / 3 + 1);
+    translate_n(seq, length, code.table, amino);
+    cseq_translate(&cs, code.table, cs_amino);
+    if (strcmp(amino, cs_amino) != 0)
+    {
+        printf("error: cseq_translate differs from translate_n\n");
+        ok = FALSE;
+    }
+
+    /* Six-frame ORFs against a search frame by frame, for a few genetic codes: */
+    static const int ids[3] = {1, 2, 11};
+    orf *expected = (orf*)malloc(2 * (length / 3 + 1) * sizeof(orf));
+    for (i = 0; i < 3; ++i)
+    {
+        genetic_code_init(&code, ids[i]);
+        size_t n = 0;
+        orf *orfs = orf_find(seq, length, &code, 30, &n);
+        const size_t n_expected = naive_orfs(seq, length, &code, 30, expected);
+        qsort(orfs, n, sizeof(orf), orf_cmp);
+        qsort(expected, n_expected, sizeof(orf), orf_cmp);
+        printf("%s: %lu ORF(s) of 30 codons or more\n", code.name, (unsigned long)n);
+        if (!same_orfs(orfs, n, expected, n_expected))
+        {
+            printf("error: orf_find differs from the frame by frame search (%lu ORFs expected)\n", (unsigned long)n_expected);
+            ok = FALSE;
+        }
+
+        /* Fed in chunks, or from the compressed sequence: */
+        orf_array chunks;
+        chunks.orfs = NULL;
+        chunks.n = 0;
+        chunks.capacity = 0;
+        orf_scanner sc;
+        orf_scanner_init(&sc, &code, 30, orf_array_add, &chunks);
+        size_t pos = 0;
+        while (pos < length)
+        {
+            size_t chunk = 1 + well1024_next_int(&rng, 1000);
+            chunk = (pos + chunk > length) ? length - pos : chunk;
+            orf_scanner_feed(&sc, seq + pos, chunk);
+            pos += chunk;
+        }
+        orf_scanner_finish(&sc);
+        orf_array packed;
+        packed.orfs = NULL;
+        packed.n = 0;
+        packed.capacity = 0;
+        cseq_orf_scan(&cs, &code, 30, orf_array_add, &packed);
+        qsort(chunks.orfs, chunks.n, sizeof(orf), orf_cmp);
+        qsort(packed.orfs, packed.n, sizeof(orf), orf_cmp);
+        if (!same_orfs(chunks.orfs, chunks.n, orfs, n))
+        {
+            printf("error: the ORFs differ when the sequence is fed in chunks\n");
+            ok = FALSE;
+        }
+        if (!same_orfs(packed.orfs, packed.n, orfs, n))
+        {
+            printf("error: cseq_orf_scan differs from orf_find\n");
+            ok = FALSE;
+        }
+        free(orfs);
+        free(chunks.orfs);
+        free(packed.orfs);
+    }
+    printf("%s\n", ok ? "ok" : "error");
+
+    free(expected);
+    free(cs_amino);
+    cseq_free(&cs);
+    free(amino);
+    free(lower);
+    free(seq);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,117 @@
+/**
+ * This file contains tests and examples for the reverse complement: the SSSE3
+ * and in-place paths, and the antisense strand of compressed sequences, are
+ * checked against a residue by residue complement.
+ *
+ * Compiling
+ * ---------
+ * gcc -Wall -O3 -mssse3 -I../devries -o example-revcomp example-revcomp.c $(xml2-config --libs) $(xml2-config --cflags) -lm -lz -pthread
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "seq.h"
+
+/* IUPAC complement of a residue, keeping the case ('U' gives 'A'). */
+char complement(char c)
+{
+    static const char *from = "ACGTURYKMBVDHSWN";
+    static const char *to = "TGCAAYRMKVBHDSWN";
+    const char *p = strchr(from, toupper((unsigned char)c));
+    if (c == '\0' || p == NULL)
+    {
+        return c;
+    }
+    return islower((unsigned char)c) ? (char)tolower((unsigned char)to[p - from]) : to[p - from];
+}
+
+int main()
+{
+    well1024 rng;
+    well1024_init(&rng, 42);
+    int ok = TRUE;
+
+    char *dst = (char*)malloc(4096);
+    char *inplace = (char*)malloc(4096);
+    char *expected = (char*)malloc(4096);
+
+    /* Any byte, every length around the 16-residue blocks: */
+    char *bytes = (char*)malloc(4096);
+    unsigned int errors = 0;
+    size_t length = 0;
+    for (; length < 4096; length += (length < 100) ? 1 : 97)
+    {
+        size_t i = 0;
+        for (; i < length; ++i)
+        {
+            bytes[i] = (char)well1024_next_int(&rng, 256);
+            expected[length - 1 - i] = complement(bytes[i]);
+        }
+        revcomp_n(bytes, length, dst);
+        memcpy(inplace, bytes, length);
+        revcomp_inplace(inplace, length);
+        if (memcmp(dst, expected, length) != 0 || memcmp(inplace, expected, length) != 0)
+        {
+            ++errors;
+        }
+    }
+    printf("revcomp_n and revcomp_inplace: %u error(s)\n", errors);
+    ok = ok && (errors == 0);
+
+    /* A reverse complement is its own inverse: */
+    char *seq = dna_random_nuc_seq(&rng, 1000);
+    char *antisense = dna_antisense(seq);
+    revcomp_inplace(antisense, 1000);
+    if (strcmp(seq, antisense) != 0)
+    {
+        printf("error: the reverse complement of the antisense strand differs from the sequence\n");
+        ok = FALSE;
+    }
+    free(antisense);
+    free(seq);
+
+    /* The antisense strand of compressed sequences, with runs of other residues
+       and lengths that are not multiples of the word: */
+    static const char *others = "NRYU";
+    errors = 0;
+    for (length = 1; length < 1000; length += 1 + well1024_next_int(&rng, 40))
+    {
+        char *s = dna_random_nuc_seq(&rng, (unsigned int)length);
+        unsigned int k = 0;
+        for (; k < 3; ++k)
+        {
+            const size_t pos = well1024_next_int(&rng, (unsigned int)length);
+            const size_t n = 1 + well1024_next_int(&rng, 10);
+            memset(s + pos, others[well1024_next_int(&rng, 4)], (pos + n > length) ? length - pos : n);
+        }
+        revcomp_n(s, length, expected);
+        expected[length] = '\0';
+
+        cseq cs, anti;
+        cseq_pack(&cs, s, (unsigned int)length);
+        cseq_antisense(&cs, &anti);
+        char *str = cseq_to_string(&anti);
+        cseq_antisense_inplace(&cs);
+        char *str_inplace = cseq_to_string(&cs);
+        if (strcmp(str, expected) != 0 || strcmp(str_inplace, expected) != 0 || cseq_cmp(&cs, &anti) != 0)
+        {
+            ++errors;
+        }
+        free(str);
+        free(str_inplace);
+        cseq_free(&anti);
+        cseq_free(&cs);
+        free(s);
+    }
+    printf("cseq_antisense and cseq_antisense_inplace: %u error(s)\n", errors);
+    ok = ok && (errors == 0);
+    printf("%s\n", ok ? "ok" : "error");
+
+    free(bytes);
+    free(expected);
+    free(inplace);
+    free(dst);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
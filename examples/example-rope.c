@@ -0,0 +1,80 @@
+/**
+ * This file contains tests and examples for the rope (editable sequence).
+ *
+ * Compiling
+ * ---------
+ * gcc -Wall -O3 -I../devries -o example-rope example-rope.c
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rope.h"
+
+/* Depth of a subtree of the treap. */
+unsigned int rope_depth(const rope *r, unsigned int t)
+{
+    if (t == 0)
+    {
+        return 0;
+    }
+    const unsigned int left = rope_depth(r, r->nodes[t].left);
+    const unsigned int right = rope_depth(r, r->nodes[t].right);
+    return 1 + ((left > right) ? left : right);
+}
+
+int main()
+{
+    const char *seq = "ACGTACGTACGTACGTACGT";
+
+    /* The rope points into 'seq', which must outlive it: */
+    rope r;
+    rope_init(&r, seq, strlen(seq));
+
+    /* Edit it anywhere, each operation is O(log p) for p pieces: */
+    rope_insert(&r, 4, "ttt", 3);
+    rope_delete(&r, 10, 5);
+    rope_set(&r, 0, 'N');
+    printf("%c at position 5, %lu residues\n", rope_get(&r, 5), (unsigned long)rope_length(&r));
+
+    char *str = rope_to_string(&r);
+    printf("rope: %s\n", str);
+
+    /* Same edits on a plain string: */
+    char expected[64];
+    strcpy(expected, seq);
+    memmove(expected + 7, expected + 4, strlen(expected + 4) + 1);
+    memcpy(expected + 4, "ttt", 3);
+    memmove(expected + 10, expected + 15, strlen(expected + 15) + 1);
+    expected[0] = 'N';
+
+    int ok = (strcmp(str, expected) == 0);
+    printf("%s\n", ok ? "ok" : "error: the rope differs from the string");
+
+    free(str);
+    rope_free(&r);
+
+    /* Many single deletions must keep the treap balanced (about 2 log2 p deep): */
+    const size_t length = 1000000;
+    char *big = (char*)malloc(length);
+    memset(big, 'A', length);
+    rope_init(&r, big, length);
+    unsigned int x = 1;
+    unsigned int i = 0;
+    for (; i < 100000; ++i)
+    {
+        x = 1103515245 * x + 12345;
+        rope_delete(&r, (x >> 1) % rope_length(&r), 1);
+    }
+    const unsigned int depth = rope_depth(&r, r.root);
+    printf("%lu residues after 100000 deletions, depth %u\n", (unsigned long)rope_length(&r), depth);
+    if (rope_length(&r) != length - 100000 || depth > 100)
+    {
+        printf("error: the deletions unbalanced the rope\n");
+        ok = 0;
+    }
+    rope_free(&r);
+    free(big);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -3,7 +3,7 @@
  *
  * Compiling
  * ---------
- * gcc -Wall -O3 -I../devries -o example-seq example-seq.c $(xml2-config --libs) $(xml2-config --cflags) -lm
+ * gcc -Wall -O3 -I../devries -o example-seq example-seq.c $(xml2-config --libs) $(xml2-config --cflags) -lm -lz -pthread
  ******************************************************************************/
 
 #include <stdio.h>
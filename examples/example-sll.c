@@ -13,13 +13,18 @@
 int main()
 {
     /* Create a list object: */
-    sll *list;
+    sll list;
 
-    /* Initialize the object: */
-    sll_init(list);
+    /* Initialize the object (the list will free the data): */
+    sll_init(&list, free);
     
     char *str = (char*)malloc(50);
     sprintf(str, "Odin");
+    sll_add_tail(&list, str);
+
+    printf("%u element(s)\n", sll_length(&list));
+
+    sll_rm_all(&list);
 
     return EXIT_SUCCESS; // Yeppie !
 }